@@ -17,6 +17,21 @@ bool in_same_directory(const fs::path &current, const fs::path &directory) {
 }
 
 namespace apptime {
+bool database::add_records(std::span<const record> actives, std::span<const record> focuses) {
+    bool result = true;
+    for (const auto &rec: actives) {
+        result = add_active(rec) && result;
+    }
+    for (const auto &rec: focuses) {
+        result = add_focus(rec) && result;
+    }
+    return result;
+}
+
+bool database::journal(std::span<const record> /*actives*/, std::span<const record> /*focuses*/) {
+    return false;
+}
+
 bool database::is_ignored(const fs::path &path) const {
     for (const auto &[type, value]: ignores()) {
         switch (type) {
@@ -2,6 +2,8 @@
 #define APPTIME_DATABASE_HPP
 
 #include <chrono>
+#include <cstdint>
+#include <span>
 #include <variant>
 
 #include <SQLiteCpp/SQLiteCpp.h>
@@ -14,6 +16,23 @@ struct record {
 
     std::string path, name;
     times_t     times;
+
+    /// @brief The version of the name, it changes only when the name changes (0 if unknown, the name is always written).
+    std::uint64_t name_version = 0;
+
+    /// @brief The ID of the executable assigned by the process manager, records with the same ID belong to the same application (0 if unknown).
+    std::uint32_t exe_id = 0;
+    /// @brief The device, inode and modification time of the executable, they keep the application of a renamed executable (0 if unknown).
+    std::uint64_t device = 0;
+    std::uint64_t inode  = 0;
+    std::int64_t  mtime  = 0;
+
+    /// @brief The CPU time consumed by the application during the intervals (0 if unknown, active records only).
+    std::chrono::milliseconds cpu_time{0};
+    /// @brief The peak resident set size of the application during the intervals in bytes (0 if unknown, active records only).
+    std::uint64_t rss_peak = 0;
+    /// @brief The average resident set size of the application during the intervals in bytes (0 if unknown, active records only).
+    std::uint64_t rss_avg = 0;
 };
 
 /// @brief Types of ignoring
@@ -52,6 +71,29 @@ public:
      */
     virtual bool add_focus(const record &rec) = 0;
 
+    /**
+     * @brief Add a batch of active and focus records to the database.
+     *
+     * The default implementation adds the records one by one, a database with transactions writes the batch by one.
+     *
+     * @param actives The active records to add.
+     * @param focuses The focus records to add.
+     * @return true if all additions are successful, false otherwise.
+     */
+    virtual bool add_records(std::span<const record> actives, std::span<const record> focuses);
+
+    /**
+     * @brief Save records that the caller keeps in memory until the next `add_records`, so they survive a crash.
+     *
+     * Saved records are dropped by the next `add_records`, or added when the database is opened again.
+     * The default implementation doesn't save records.
+     *
+     * @param actives The active records to save.
+     * @param focuses The focus records to save.
+     * @return true if the records are saved, false otherwise.
+     */
+    virtual bool journal(std::span<const record> actives, std::span<const record> focuses);
+
     /**
      * @brief Add an entry to the ignore list.
      *
@@ -1,5 +1,6 @@
 #include "database_sqlite.hpp"
 
+#include <algorithm>
 #include <unordered_map>
 
 #include <sqlite3.h>
@@ -33,11 +34,14 @@ private:
 };
 
 void select_records::update() {
-    query_ = std::format("SELECT a.path, a.name, {}, {} FROM {} AS logs "
+    // only active intervals have the resource usage
+    const std::string_view usage = table_name_ == "active_logs" ? "logs.cpu_time, logs.rss_peak, logs.rss_avg" : "0, 0, 0";
+
+    query_ = std::format("SELECT a.path, a.name, {}, {}, {} FROM {} AS logs "
                          "JOIN applications AS a ON logs.program_id = a.id AND IS_IGNORED(a.path)=0 "
                          "{} "
                          "ORDER BY a.path",
-                         logs_start(), logs_end(), table_name_, where());
+                         logs_start(), logs_end(), usage, table_name_, where());
 }
 
 std::string select_records::logs_start() const {
@@ -157,6 +161,9 @@ std::string ignore_to_string(apptime::ignore_type value) {
     return "";
 }
 
+// the version of the schema, every version above 0 has a step in database_sqlite::migrate
+constexpr int schema_version = 2;
+
 apptime::ignore_type string_to_enum(std::string_view value) {
     // clang-format off
     static const std::unordered_map<std::string_view, apptime::ignore_type> ignores = {
@@ -171,7 +178,9 @@ apptime::ignore_type string_to_enum(std::string_view value) {
 }
 
 namespace apptime {
-database_sqlite::database_sqlite(const std::filesystem::path &path) : db_{path.string(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE} {
+database_sqlite::database_sqlite(const std::filesystem::path &path)
+    : db_{path.string(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE},
+      journal_{path.string() + ".journal"} {
     // create the applications table
     db_.exec("CREATE TABLE IF NOT EXISTS applications ("
              "id INTEGER NOT NULL,"
@@ -200,59 +209,142 @@ database_sqlite::database_sqlite(const std::filesystem::path &path) : db_{path.s
              "type CHECK(type IN ('file', 'path')) NOT NULL,"
              "value TEXT NOT NULL)");
 
+    migrate();
+
     // create the ignore function
     db_.createFunction("IS_IGNORED", 1, false, this, &is_ignored_sqlite);
+
+    // records journaled before a crash, the intervals are keyed by their start, so a record written before the crash is replaced
+    std::vector<record> actives;
+    std::vector<record> focuses;
+    bool                committed = true;
+    if (journal_.read(actives, focuses)) {
+        write_records(actives, focuses, &committed);
+    }
+    if (committed) {
+        journal_.clear();
+    }
 }
 
-bool database_sqlite::add_active(const record &rec) {
-    if (!valid_application(rec)) {
-        return false;
+void database_sqlite::migrate() {
+    const int version = db_.execAndGet("PRAGMA user_version").getInt();
+    if (version >= schema_version) {
+        return;
     }
 
     SQLite::Transaction transaction{db_};
-    bool                result = true;
-    SQLite::Statement   insert{db_, "INSERT OR REPLACE INTO active_logs (program_id, start, end) VALUES "
-                                    "((SELECT id FROM applications WHERE path=?), ?, ?)"};
-    for (const auto &[start, end]: rec.times) {
-        const std::string start_str = std::format("{:L%F %T}", start);
-        const std::string end_str   = std::format("{:L%F %T}", end);
 
-        insert.bind(1, rec.path);
-        insert.bind(2, start_str);
-        insert.bind(3, end_str);
-        result = result && insert.exec() == 1;
+    // 1: the resource usage of active intervals, it's aggregated by monitoring and written with the interval
+    if (version < 1) {
+        db_.exec("ALTER TABLE active_logs ADD COLUMN cpu_time INTEGER NOT NULL DEFAULT 0");
+        db_.exec("ALTER TABLE active_logs ADD COLUMN rss_peak INTEGER NOT NULL DEFAULT 0");
+        db_.exec("ALTER TABLE active_logs ADD COLUMN rss_avg INTEGER NOT NULL DEFAULT 0");
+    }
 
-        insert.reset();
-        insert.clearBindings();
+    // 2: the identity of the executable, a renamed executable is found by it
+    if (version < 2) {
+        db_.exec("ALTER TABLE applications ADD COLUMN device INTEGER NOT NULL DEFAULT 0");
+        db_.exec("ALTER TABLE applications ADD COLUMN inode INTEGER NOT NULL DEFAULT 0");
+        db_.exec("ALTER TABLE applications ADD COLUMN mtime INTEGER NOT NULL DEFAULT 0");
+        db_.exec("CREATE INDEX IF NOT EXISTS applications_exe ON applications(device, inode, mtime)");
     }
 
+    db_.exec(std::format("PRAGMA user_version={}", schema_version));
     transaction.commit();
-    return result;
+}
+
+bool database_sqlite::add_active(const record &rec) {
+    return write_records({&rec, 1}, {});
 }
 
 bool database_sqlite::add_focus(const record &rec) {
-    if (!valid_application(rec)) {
-        return false;
+    return write_records({}, {&rec, 1});
+}
+
+bool database_sqlite::add_records(std::span<const record> actives, std::span<const record> focuses) {
+    // the journal keeps the records of a batch that isn't committed, they are replayed by the next start
+    bool       committed = false;
+    const bool result    = write_records(actives, focuses, &committed);
+    if (committed) {
+        journal_.clear();
     }
+    return result;
+}
+
+bool database_sqlite::journal(std::span<const record> actives, std::span<const record> focuses) {
+    return journal_.append(actives, focuses);
+}
 
+bool database_sqlite::write_records(std::span<const record> actives, std::span<const record> focuses, bool *committed) {
+    // a batch is synced to the disk once, however many records it has, new applications are registered by the same transaction
     SQLite::Transaction transaction{db_};
-    bool                result = true;
-    SQLite::Statement   insert{db_, "INSERT OR REPLACE INTO focus_logs (program_id, start, end) VALUES "
-                                    "((SELECT id FROM applications WHERE path=?), ?, ?)"};
+    try {
+        bool                      result = true;
+        std::vector<std::int64_t> ids;
+        ids.reserve(actives.size() + focuses.size());
+        for (const auto &rec: actives) {
+            ids.push_back(application_id(rec));
+        }
+        for (const auto &rec: focuses) {
+            ids.push_back(application_id(rec));
+        }
+        // nothing to write, e.g. all applications are ignored
+        if (std::ranges::all_of(ids, [](std::int64_t id) { return id == 0; })) {
+            transaction.commit();
+            if (committed) {
+                *committed = true;
+            }
+            return ids.empty();
+        }
+
+        // an interval written again is updated in place, REPLACE would delete the row and insert it again
+        SQLite::Statement insert_active{db_, "INSERT INTO active_logs (program_id, start, end, cpu_time, rss_peak, rss_avg) VALUES (?, ?, ?, ?, ?, ?) "
+                                             "ON CONFLICT (program_id, start) DO UPDATE SET "
+                                             "end=excluded.end, cpu_time=excluded.cpu_time, rss_peak=excluded.rss_peak, rss_avg=excluded.rss_avg"};
+        SQLite::Statement insert_focus{db_, "INSERT INTO focus_logs (program_id, start, end) VALUES (?, ?, ?) "
+                                            "ON CONFLICT (program_id, start) DO UPDATE SET end=excluded.end"};
+
+        auto id = ids.begin();
+        for (const auto &rec: actives) {
+            result = *id != 0 && insert_times(insert_active, *id, rec, true) && result;
+            id++;
+        }
+        for (const auto &rec: focuses) {
+            result = *id != 0 && insert_times(insert_focus, *id, rec, false) && result;
+            id++;
+        }
+
+        transaction.commit();
+        if (committed) {
+            *committed = true;
+        }
+        return result;
+    } catch (...) {
+        // the registrations are rolled back with the batch, so cached IDs of new applications may not exist
+        stale_caches_ = true;
+        throw;
+    }
+}
+
+bool database_sqlite::insert_times(SQLite::Statement &insert, std::int64_t id, const record &rec, bool usage) {
+    bool result = true;
     for (const auto &[start, end]: rec.times) {
         const std::string start_str = std::format("{:L%F %T}", start);
         const std::string end_str   = std::format("{:L%F %T}", end);
 
-        insert.bind(1, rec.path);
+        insert.bind(1, id);
         insert.bind(2, start_str);
         insert.bind(3, end_str);
+        if (usage) {
+            insert.bind(4, static_cast<std::int64_t>(rec.cpu_time.count()));
+            insert.bind(5, static_cast<std::int64_t>(rec.rss_peak));
+            insert.bind(6, static_cast<std::int64_t>(rec.rss_avg));
+        }
         result = result && insert.exec() == 1;
 
         insert.reset();
         insert.clearBindings();
     }
-
-    transaction.commit();
     return result;
 }
 
@@ -266,6 +358,8 @@ void database_sqlite::add_ignore(ignore_type type, std::string_view value) {
     insert.bind(1, type_str);
     insert.bind(2, std::string{value});
     insert.exec();
+
+    stale_caches_ = true;
 }
 
 void database_sqlite::remove_ignore(ignore_type type, std::string_view value) {
@@ -278,6 +372,8 @@ void database_sqlite::remove_ignore(ignore_type type, std::string_view value) {
     remove.bind(1, type_str);
     remove.bind(2, std::string{value});
     remove.exec();
+
+    stale_caches_ = true;
 }
 
 std::vector<record> database_sqlite::actives(const options &opt) const {
@@ -316,44 +412,129 @@ std::vector<record> database_sqlite::records_detail(std::string_view table, cons
 }
 
 std::vector<record> database_sqlite::fill_records(SQLite::Statement &select) {
-    using select_t = std::tuple<std::string, std::string, std::string, std::string>;
+    using select_t = std::tuple<std::string, std::string, std::string, std::string, std::int64_t, std::int64_t, std::int64_t>;
 
     std::vector<record> result;
     record              rec;
 
+    // the usage of intervals is summed up per application, the average resident set size is weighted by the interval duration
+    double rss_weighted = 0;
+    double duration_sum = 0;
+    const auto finish   = [&result, &rec, &rss_weighted, &duration_sum] {
+        if (rec.path.empty() || rec.times.empty()) {
+            return;
+        }
+        rec.rss_avg = duration_sum > 0 ? static_cast<std::uint64_t>(rss_weighted / duration_sum) : 0;
+        result.emplace_back(rec);
+    };
+
     while (select.executeStep()) {
-        const auto [path, name, start_str, end_str] = select.getColumns<select_t, 4>();
+        const auto [path, name, start_str, end_str, cpu_time, rss_peak, rss_avg] = select.getColumns<select_t, 7>();
 
         if (rec.path != path) {
-            if (!rec.path.empty() && !rec.times.empty()) {
-                result.emplace_back(rec);
-            }
-            rec.path = path;
-            rec.name = name;
+            finish();
+            rec.path     = path;
+            rec.name     = name;
+            rec.cpu_time = {};
+            rec.rss_peak = 0;
+            rss_weighted = 0;
+            duration_sum = 0;
             rec.times.clear();
         }
 
         const auto start = parse_time(start_str);
         const auto end   = parse_time(end_str);
         rec.times.emplace_back(start, end);
+
+        const double duration = std::chrono::duration<double>(end - start).count();
+        rec.cpu_time += std::chrono::milliseconds{cpu_time};
+        rec.rss_peak = std::max(rec.rss_peak, static_cast<std::uint64_t>(rss_peak));
+        rss_weighted += static_cast<double>(rss_avg) * duration;
+        duration_sum += duration;
     }
-    if (!rec.path.empty() && !rec.times.empty()) {
-        result.emplace_back(rec);
-    }
+    finish();
 
     return result;
 }
 
-bool database_sqlite::valid_application(const record &rec) {
-    if (rec.path.empty() || is_ignored(rec.path)) {
-        return false;
+std::int64_t database_sqlite::application_id(const record &rec) {
+    if (rec.path.empty()) {
+        return 0;
     }
 
-    SQLite::Statement update{db_, "INSERT INTO applications(path, name) VALUES (?, ?) "
-                                  "ON CONFLICT(path) DO UPDATE SET name=excluded.name;"};
+    // the ignore list is changed by another thread, so the caches are dropped here instead of by add_ignore and remove_ignore
+    if (stale_caches_.exchange(false)) {
+        by_exe_.clear();
+        by_path_.clear();
+    }
+
+    // records of a known executable are looked up by an integer, only records without one hash the path
+    application *cached = nullptr;
+    if (rec.exe_id != 0) {
+        if (const auto it = by_exe_.find(rec.exe_id); it != by_exe_.end()) {
+            cached = &it->second;
+        }
+    } else if (const auto it = by_path_.find(rec.path); it != by_path_.end()) {
+        cached = &it->second;
+    }
+
+    // the application is ignored, or it's registered and its name hasn't changed.
+    // records without a window (or replayed from the journal) have no name version, so their names are compared
+    if (cached && (cached->id == 0 || (rec.name_version != 0 ? cached->name_version == rec.name_version : cached->name == rec.name))) {
+        return cached->id;
+    }
+
+    application app{.name_version = rec.name_version, .name = rec.name};
+    if (!is_ignored(rec.path)) {
+        app.id = register_application(rec);
+        if (app.id == 0) {
+            return 0;
+        }
+    }
+    if (rec.exe_id != 0) {
+        by_exe_.insert_or_assign(rec.exe_id, app);
+    } else {
+        by_path_.insert_or_assign(rec.path, app);
+    }
+    return app.id;
+}
+
+std::int64_t database_sqlite::register_application(const record &rec) {
+    // a renamed executable is the same file, the application keeps the path it was registered with
+    if (rec.inode != 0) {
+        SQLite::Statement select{db_, "SELECT id FROM applications WHERE device=? AND inode=? AND mtime=?"};
+        select.bind(1, static_cast<std::int64_t>(rec.device));
+        select.bind(2, static_cast<std::int64_t>(rec.inode));
+        select.bind(3, rec.mtime);
+        if (select.executeStep()) {
+            const std::int64_t id = select.getColumn(0).getInt64();
+
+            SQLite::Statement update{db_, "UPDATE applications SET name=? WHERE id=?"};
+            update.bind(1, rec.name);
+            update.bind(2, id);
+            update.exec();
+            return id;
+        }
+    }
+
+    // an upgraded executable is a new file with the same path, its identity replaces the old one
+    SQLite::Statement update{db_, "INSERT INTO applications(path, name, device, inode, mtime) VALUES (?, ?, ?, ?, ?) "
+                                  "ON CONFLICT(path) DO UPDATE SET name=excluded.name, "
+                                  "device=CASE WHEN excluded.inode=0 THEN device ELSE excluded.device END, "
+                                  "inode=CASE WHEN excluded.inode=0 THEN inode ELSE excluded.inode END, "
+                                  "mtime=CASE WHEN excluded.inode=0 THEN mtime ELSE excluded.mtime END;"};
     update.bind(1, rec.path);
     update.bind(2, rec.name);
-    return update.exec() == 1;
+    update.bind(3, static_cast<std::int64_t>(rec.device));
+    update.bind(4, static_cast<std::int64_t>(rec.inode));
+    update.bind(5, rec.mtime);
+    if (update.exec() != 1) {
+        return 0;
+    }
+
+    SQLite::Statement select{db_, "SELECT id FROM applications WHERE path=?"};
+    select.bind(1, rec.path);
+    return select.executeStep() ? select.getColumn(0).getInt64() : 0;
 }
 
 void database_sqlite::is_ignored_sqlite(sqlite3_context *context, int argc, sqlite3_value **argv) {
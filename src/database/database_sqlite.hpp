@@ -1,7 +1,11 @@
 #ifndef APPTIME_DATABASE_SQLITE_HPP
 #define APPTIME_DATABASE_SQLITE_HPP
 
+#include <atomic>
+#include <unordered_map>
+
 #include "database.hpp"
+#include "record_journal.hpp"
 
 namespace apptime {
 class database_sqlite : public database {
@@ -9,6 +13,8 @@ public:
     /**
      * @brief Construct a new database object.
      *
+     * Records of the journal (the file path with `.journal` appended) that weren't written before a crash are added first.
+     *
      * @param path File path.
      */
     explicit database_sqlite(const std::filesystem::path &path);
@@ -31,6 +37,24 @@ public:
      */
     bool add_focus(const record &rec) override;
 
+    /**
+     * @brief Add a batch of active and focus records to the database by one transaction, the journal is cleared after the commit.
+     *
+     * @param actives The active records to add.
+     * @param focuses The focus records to add.
+     * @return true if all additions are successful, false otherwise.
+     */
+    bool add_records(std::span<const record> actives, std::span<const record> focuses) override;
+
+    /**
+     * @brief Append records to the journal, they are written by the next `add_records` or replayed by the next constructor.
+     *
+     * @param actives The active records to save.
+     * @param focuses The focus records to save.
+     * @return true if the records are on the disk, false otherwise.
+     */
+    bool journal(std::span<const record> actives, std::span<const record> focuses) override;
+
     /**
      * @brief Add an entry to the ignore list.
      *
@@ -71,6 +95,32 @@ public:
     std::vector<ignore> ignores() const override;
 
 private:
+    /// @brief Upgrade the schema of an existing database to the current version (stored in `PRAGMA user_version`).
+    void migrate();
+
+    /**
+     * @brief Write records by one transaction, the journal isn't changed.
+     *
+     * Applications are registered before the transaction, so the cached IDs are never rolled back.
+     *
+     * @param actives The active records.
+     * @param focuses The focus records.
+     * @param committed Set to true if the transaction is committed or there's nothing to write (nullptr to ignore it).
+     * @return true if all records are written, false otherwise.
+     */
+    bool write_records(std::span<const record> actives, std::span<const record> focuses, bool *committed = nullptr);
+
+    /**
+     * @brief Bind and execute the insert statement for every interval of a record.
+     *
+     * @param insert The insert statement of active_logs or focus_logs.
+     * @param id The application ID.
+     * @param rec The record.
+     * @param usage true to bind the resource usage (active_logs only).
+     * @return true if all intervals are written, false otherwise.
+     */
+    static bool insert_times(SQLite::Statement &insert, std::int64_t id, const record &rec, bool usage);
+
     /**
      * @brief Retrieves records based on the provided options and table name.
      *
@@ -81,16 +131,26 @@ private:
     std::vector<record> records_detail(std::string_view table, const options &opt) const;
 
     /**
-     * @brief Validates whether the provided record is valid for insertion.
+     * @brief Get the ID of the application of a record.
      *
-     * This method checks if the provided record is valid for insertion into the database.
-     * It verifies whether the application path is not empty, not ignored, and updates the application's name if it exists,
-     * or registers a new application if it doesn't.
+     * This method checks if the application path is not empty and not ignored, and updates the application's name if it exists,
+     * or registers a new application if it doesn't. The result is cached by the executable ID of the record (or by the path without one),
+     * so the name is updated only if its version differs from the last written one.
      *
-     * @param act The record to validate.
-     * @return true if the active record is valid and successfully inserted, false otherwise.
+     * @param rec The record.
+     * @return std::int64_t The application ID, or 0 if the record can't be written.
      */
-    bool valid_application(const record &rec);
+    std::int64_t application_id(const record &rec);
+
+    /**
+     * @brief Register an application or update its name.
+     *
+     * An application with the same executable (device, inode and modification time) is found first, so a renamed executable keeps its history.
+     *
+     * @param rec The record.
+     * @return std::int64_t The application ID, or 0 if the application can't be registered.
+     */
+    std::int64_t register_application(const record &rec);
 
     /**
      * @brief Fills the records vector based on the provided SQLite statement.
@@ -111,6 +171,26 @@ private:
 
     /// @brief The SQLite database instance.
     SQLite::Database db_;
+
+    /// @brief Records saved by `journal` since the last `add_records`.
+    record_journal journal_;
+
+    /// @brief A cached application.
+    struct application {
+        /// @brief The application ID (0 if the application is ignored).
+        std::int64_t id = 0;
+        /// @brief The last written name version (see record::name_version).
+        std::uint64_t name_version = 0;
+        /// @brief The last written name, it's compared for records without a name version.
+        std::string name;
+    };
+
+    /// @brief Cached applications by executable ID (see record::exe_id) and by path for records without one, used only by the writing thread.
+    std::unordered_map<std::uint32_t, application> by_exe_;
+    std::unordered_map<std::string, application>   by_path_;
+
+    /// @brief Set when the ignore list changes, the writing thread drops the cached applications before its next lookup.
+    std::atomic_bool stale_caches_{false};
 };
 } // namespace apptime
 
@@ -0,0 +1,209 @@
+#include "record_journal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// the first line of a journal, the number is the version of the format
+constexpr std::string_view journal_header = "apptime-journal\t1";
+
+// kind, start, end, exe_id, device, inode, mtime, name_version, cpu_time, rss_peak, rss_avg, path, name
+constexpr std::size_t journal_fields = 13;
+
+// flush the data of a file to the disk
+bool sync_journal(std::FILE *file) {
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#elif defined(__linux__)
+    return fdatasync(fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// tabs and line breaks separate fields and lines, so they are escaped in strings
+void journal_escape(std::string &out, std::string_view value) {
+    for (const char c: value) {
+        switch (c) {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        default:
+            out += c;
+            break;
+        }
+    }
+}
+
+std::string journal_unescape(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (std::size_t i = 0; i < value.size(); i++) {
+        if (value[i] != '\\' || i + 1 == value.size()) {
+            result += value[i];
+            continue;
+        }
+        switch (value[++i]) {
+        case 't':
+            result += '\t';
+            break;
+        case 'n':
+            result += '\n';
+            break;
+        default:
+            result += value[i];
+            break;
+        }
+    }
+    return result;
+}
+
+template <typename T>
+bool parse_journal_number(std::string_view value, T &result) {
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+    return error == std::errc{} && end == value.data() + value.size();
+}
+
+std::int64_t journal_time(apptime::record::time_point_t time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// a line per interval, records with several intervals are read back as several records
+void journal_line(std::string &out, char kind, const apptime::record &rec) {
+    for (const auto &[start, end]: rec.times) {
+        out += std::format("{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t", kind, journal_time(start), journal_time(end), rec.exe_id, rec.device, rec.inode,
+                           rec.mtime, rec.name_version, rec.cpu_time.count(), rec.rss_peak, rec.rss_avg);
+        journal_escape(out, rec.path);
+        out += '\t';
+        journal_escape(out, rec.name);
+        out += '\n';
+    }
+}
+
+// parse a line into a record, returns the kind of the record or 0 if the line is invalid
+char parse_journal_line(std::string_view line, apptime::record &rec) {
+    std::array<std::string_view, journal_fields> fields;
+    for (std::size_t i = 0; i < fields.size(); i++) {
+        const std::size_t tab = i + 1 < fields.size() ? line.find('\t') : line.size();
+        if (tab == std::string_view::npos) {
+            return 0;
+        }
+        fields[i] = line.substr(0, tab);
+        line.remove_prefix(std::min(tab + 1, line.size()));
+    }
+
+    const char kind = fields[0] == "a" || fields[0] == "f" ? fields[0][0] : 0;
+
+    std::int64_t start    = 0;
+    std::int64_t end      = 0;
+    std::int64_t cpu_time = 0;
+    const bool   parsed   = parse_journal_number(fields[1], start) && parse_journal_number(fields[2], end) && parse_journal_number(fields[3], rec.exe_id) &&
+                        parse_journal_number(fields[4], rec.device) && parse_journal_number(fields[5], rec.inode) &&
+                        parse_journal_number(fields[6], rec.mtime) && parse_journal_number(fields[7], rec.name_version) &&
+                        parse_journal_number(fields[8], cpu_time) && parse_journal_number(fields[9], rec.rss_peak) &&
+                        parse_journal_number(fields[10], rec.rss_avg);
+    if (kind == 0 || !parsed) {
+        return 0;
+    }
+
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    using duration = apptime::record::time_point_t::duration;
+    rec.times.emplace_back(apptime::record::time_point_t{duration_cast<duration>(nanoseconds{start})},
+                           apptime::record::time_point_t{duration_cast<duration>(nanoseconds{end})});
+    rec.cpu_time = std::chrono::milliseconds{cpu_time};
+    rec.path     = journal_unescape(fields[11]);
+    rec.name     = journal_unescape(fields[12]);
+
+    // the IDs of the run that wrote the journal may belong to other executables in this run
+    rec.exe_id       = 0;
+    rec.name_version = 0;
+    return kind;
+}
+
+namespace apptime {
+record_journal::record_journal(std::filesystem::path path) : path_{std::move(path)} {}
+
+record_journal::~record_journal() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool record_journal::append(std::span<const record> actives, std::span<const record> focuses) {
+    if (!file_) {
+        file_ = std::fopen(path_.string().c_str(), "ab");
+        if (!file_) {
+            return false;
+        }
+    }
+
+    // the whole batch is written by one call, so a crash can only cut its last line
+    std::string lines;
+    if (std::fseek(file_, 0, SEEK_END) == 0 && std::ftell(file_) == 0) {
+        lines = journal_header;
+        lines += '\n';
+    }
+    for (const auto &rec: actives) {
+        journal_line(lines, 'a', rec);
+    }
+    for (const auto &rec: focuses) {
+        journal_line(lines, 'f', rec);
+    }
+
+    return std::fwrite(lines.data(), 1, lines.size(), file_) == lines.size() && std::fflush(file_) == 0 && sync_journal(file_);
+}
+
+bool record_journal::read(std::vector<record> &actives, std::vector<record> &focuses) const {
+    std::ifstream file{path_, std::ios::binary};
+    std::string   line;
+    if (!std::getline(file, line) || line != journal_header) {
+        return false;
+    }
+
+    bool result = false;
+    while (std::getline(file, line)) {
+        // the last line has no line break if the append was interrupted
+        if (file.eof()) {
+            break;
+        }
+
+        record     rec;
+        const char kind = parse_journal_line(line, rec);
+        if (kind == 'a') {
+            actives.emplace_back(std::move(rec));
+        } else if (kind == 'f') {
+            focuses.emplace_back(std::move(rec));
+        }
+        result = result || kind != 0;
+    }
+    return result;
+}
+
+void record_journal::clear() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    std::error_code error;
+    std::filesystem::remove(path_, error);
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef APPTIME_RECORD_JOURNAL_HPP
+#define APPTIME_RECORD_JOURNAL_HPP
+
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "database.hpp"
+
+namespace apptime {
+/**
+ * @brief An append-only file of records that aren't written to the database yet.
+ *
+ * Records are appended as tab-separated lines, one line per interval, and every append is flushed to the disk.
+ * A line interrupted by a crash has no line break and it's skipped when the journal is read.
+ * The journal is cleared after its records are written to the database, a record read twice overwrites itself.
+ */
+class record_journal {
+public:
+    /**
+     * @brief Construct a new journal, the file is created by the first append.
+     *
+     * @param path The file path.
+     */
+    explicit record_journal(std::filesystem::path path);
+    ~record_journal();
+
+    record_journal(const record_journal &)            = delete;
+    record_journal &operator=(const record_journal &) = delete;
+
+    /**
+     * @brief Append records to the journal and flush them to the disk.
+     *
+     * @param actives The active records.
+     * @param focuses The focus records.
+     * @return true if the records are on the disk, false otherwise.
+     */
+    bool append(std::span<const record> actives, std::span<const record> focuses);
+
+    /**
+     * @brief Read the records of the journal.
+     *
+     * The executable IDs and the name versions are numbered anew by every run, so they are read as 0 (unknown)
+     * and the records are looked up by their paths and executable identities.
+     *
+     * @param actives The active records are appended to it.
+     * @param focuses The focus records are appended to it.
+     * @return true if the journal has records, false otherwise.
+     */
+    bool read(std::vector<record> &actives, std::vector<record> &focuses) const;
+
+    /// @brief Remove all records from the journal.
+    void clear();
+
+    const std::filesystem::path &path() const { return path_; }
+
+private:
+    std::filesystem::path path_;
+    /// @brief The file opened by the first append (nullptr before it).
+    std::FILE *file_ = nullptr;
+};
+} // namespace apptime
+
+#endif // APPTIME_RECORD_JOURNAL_HPP
\ No newline at end of file
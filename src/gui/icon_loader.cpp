@@ -0,0 +1,99 @@
+#include "icon_loader.hpp"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QPixmap>
+#include <QStandardPaths>
+
+#include "platforms/icon.hpp"
+
+namespace apptime {
+icon_loader::icon_loader(QObject *parent)
+    : QObject{parent}, theme_{QIcon::themeName()}, directory_{QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/icons"} {
+    QDir{}.mkpath(directory_);
+    thread_ = std::thread{&icon_loader::worker_thread, this};
+}
+
+icon_loader::~icon_loader() {
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+QIcon icon_loader::icon(const std::string &path) {
+    const QString key = QString::fromStdString(path);
+    if (const QPixmap *pixmap = cache_.object(key)) {
+        return pixmap->isNull() ? QIcon{} : QIcon{*pixmap};
+    }
+
+    // the icon is requested once, rows that show it are updated by the signal
+    if (!key.isEmpty() && !pending_.contains(key)) {
+        pending_.insert(key);
+        {
+            const std::lock_guard<std::mutex> lock{mutex_};
+            queue_.push_back(key);
+        }
+        cv_.notify_one();
+    }
+    return {};
+}
+
+void icon_loader::worker_thread() {
+    while (true) {
+        QString path;
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (stop_) {
+                return;
+            }
+            path = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        // QPixmap can be created only by the GUI thread, the worker passes the decoded image
+        QImage image = load(path);
+        QMetaObject::invokeMethod(
+            this,
+            [this, path, image = std::move(image)] {
+                pending_.remove(path);
+
+                const QPixmap pixmap = QPixmap::fromImage(image);
+                cache_.insert(path, new QPixmap{pixmap});
+                if (!pixmap.isNull()) {
+                    emit iconLoaded(path, QIcon{pixmap});
+                }
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+QImage icon_loader::load(const QString &path) const {
+    const QString   file = thumbnail(path);
+    const QFileInfo info{file};
+    if (info.exists() && info.lastModified() >= QFileInfo{path}.lastModified()) {
+        if (QImage image{file}; !image.isNull()) {
+            return image;
+        }
+    }
+
+    QImage image = application_image(path.toStdString(), icon_size, theme_);
+    if (!image.isNull()) {
+        image.save(file, "PNG");
+    }
+    return image;
+}
+
+QString icon_loader::thumbnail(const QString &path) const {
+    // the theme and the size are a part of the key, so changing them doesn't use old thumbnails
+    const QByteArray key = QStringLiteral("%1\n%2\n%3").arg(path, theme_).arg(icon_size).toUtf8();
+    return directory_ + '/' + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex()) + ".png";
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef APPTIME_GUI_ICON_LOADER_HPP
+#define APPTIME_GUI_ICON_LOADER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <QCache>
+#include <QIcon>
+#include <QObject>
+#include <QSet>
+
+namespace apptime {
+/**
+ * @brief The class loads icons of applications on a worker thread.
+ *
+ * Decoded icons are kept in a bounded LRU cache by the executable path, and the scaled images are saved as PNG thumbnails
+ * to the cache directory, so the next start doesn't decode the original files. A thumbnail is valid while it's newer than the executable.
+ * The class is used only by the GUI thread, loaded icons are delivered by the `iconLoaded` signal.
+ */
+class icon_loader : public QObject {
+    Q_OBJECT
+
+public:
+    /// @brief The size of icons in pixels.
+    static constexpr int icon_size = 32;
+    /// @brief The maximum number of icons in memory.
+    static constexpr int cache_size = 256;
+
+    explicit icon_loader(QObject *parent = nullptr);
+    ~icon_loader() override;
+
+    icon_loader(const icon_loader &)            = delete;
+    icon_loader &operator=(const icon_loader &) = delete;
+
+    /**
+     * @brief Get the icon of an application, it doesn't block.
+     *
+     * @param path The full path of the executable.
+     * @return QIcon The icon if it's cached, otherwise an empty icon and the icon is loaded in the background.
+     */
+    QIcon icon(const std::string &path);
+
+signals:
+    void iconLoaded(const QString &path, const QIcon &icon);
+
+private:
+    void worker_thread();
+
+    // load the thumbnail from the disk cache or load the icon and save the thumbnail
+    QImage load(const QString &path) const;
+
+    // the path of the thumbnail of an executable
+    QString thumbnail(const QString &path) const;
+
+    // used only by the GUI thread, null pixmaps are cached for applications without an icon
+    QCache<QString, QPixmap> cache_{cache_size};
+    QSet<QString>            pending_;
+
+    QString theme_;
+    QString directory_;
+
+    std::thread             thread_;
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    std::deque<QString>     queue_;
+    bool                    stop_ = false;
+};
+} // namespace apptime
+
+#endif // APPTIME_GUI_ICON_LOADER_HPP
\ No newline at end of file
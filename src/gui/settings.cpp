@@ -4,8 +4,33 @@
 #include <QAction>
 #include <QFormLayout>
 #include <QHBoxLayout>
+#include <QHeaderView>
 #include <QIntValidator>
 #include <QSettings>
+#include <QVBoxLayout>
+
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <vector>
+
+// the refresh interval of the diagnostics page
+constexpr int diagnostics_refresh = 1000;
+
+// a latency in the largest unit in which it's at least 1
+QString format_latency(std::chrono::nanoseconds value) {
+    const auto count = static_cast<double>(value.count());
+    if (value >= std::chrono::seconds{1}) {
+        return QStringLiteral("%1 s").arg(count / 1e9, 0, 'f', 2);
+    }
+    if (value >= std::chrono::milliseconds{1}) {
+        return QStringLiteral("%1 ms").arg(count / 1e6, 0, 'f', 2);
+    }
+    if (value >= std::chrono::microseconds{1}) {
+        return QStringLiteral("%1 µs").arg(count / 1e3, 0, 'f', 1);
+    }
+    return QStringLiteral("%1 ns").arg(value.count());
+}
 
 namespace apptime {
 settings_window::settings_window(QWidget *parent) : QWidget{parent}, listbox_{new QListWidget}, widgets_{new QStackedWidget} {
@@ -13,6 +38,7 @@ settings_window::settings_window(QWidget *parent) : QWidget{parent}, listbox_{ne
 
     // widgets
     initMonitoringSettings();
+    initDiagnostics();
 
     auto *hbox = new QHBoxLayout{this};
     hbox->addWidget(listbox_, 0);
@@ -68,6 +94,48 @@ void settings_window::readSettings() {
     const auto focus_delay           = settings.value("focus_delay", 5000).toInt();
     window_ptr->monitor_.focus_delay = std::chrono::milliseconds{focus_delay};
     focus_delay_->setValue(focus_delay);
+
+    const auto adaptive            = settings.value("adaptive", false).toBool();
+    const auto min_delay           = settings.value("min_delay", 250).toInt();
+    window_ptr->monitor_.adaptive  = adaptive;
+    window_ptr->monitor_.min_delay = std::chrono::milliseconds{min_delay};
+    adaptive_->setChecked(adaptive);
+    min_delay_->setValue(min_delay);
+    min_delay_->setEnabled(adaptive);
+
+    const auto scan_workers           = settings.value("scan_workers", 1).toInt();
+    window_ptr->monitor_.scan_workers = static_cast<unsigned>(scan_workers);
+    scan_workers_->setValue(scan_workers);
+
+    const auto flush_interval           = settings.value("flush_interval", 30).toInt();
+    window_ptr->monitor_.flush_interval = std::chrono::seconds{flush_interval};
+    flush_interval_->setValue(flush_interval);
+
+    const auto scan_scope  = settings.value("scan_scope", 0).toInt();
+    const auto scan_cgroup = settings.value("scan_cgroup", QString{}).toString();
+    window_ptr->monitor_.scan_scope({
+        .current_user = scan_scope == 1,
+        .cgroup       = scan_scope == 2 ? scan_cgroup.toStdString() : std::string{},
+    });
+    scan_scope_->setCurrentIndex(scan_scope);
+    scan_cgroup_->setText(scan_cgroup);
+    scan_cgroup_->setEnabled(scan_scope == 2);
+
+    // one rule per line
+    const auto               fold_tree  = settings.value("fold_tree", false).toBool();
+    const auto               tree_roots = settings.value("tree_roots", QStringList{}).toStringList();
+    std::vector<std::string> roots;
+    if (fold_tree) {
+        for (const auto &root: tree_roots) {
+            if (!root.trimmed().isEmpty()) {
+                roots.push_back(root.trimmed().toStdString());
+            }
+        }
+    }
+    window_ptr->monitor_.tree_roots(std::move(roots));
+    fold_tree_->setChecked(fold_tree);
+    tree_roots_->setPlainText(tree_roots.join('\n'));
+    tree_roots_->setEnabled(fold_tree);
     settings.endGroup();
 }
 
@@ -95,6 +163,14 @@ void settings_window::saveSettings() {
     settings.beginGroup("monitoring");
     settings.setValue("active_delay", active_delay_->value());
     settings.setValue("focus_delay", focus_delay_->value());
+    settings.setValue("adaptive", adaptive_->isChecked());
+    settings.setValue("min_delay", min_delay_->value());
+    settings.setValue("scan_workers", scan_workers_->value());
+    settings.setValue("flush_interval", flush_interval_->value());
+    settings.setValue("scan_scope", scan_scope_->currentIndex());
+    settings.setValue("scan_cgroup", scan_cgroup_->text());
+    settings.setValue("fold_tree", fold_tree_->isChecked());
+    settings.setValue("tree_roots", tree_roots_->toPlainText().split('\n', Qt::SkipEmptyParts));
     settings.endGroup();
 }
 
@@ -112,9 +188,104 @@ void settings_window::initMonitoringSettings() {
     focus_delay_->setMaximum(std::numeric_limits<int>::max());
     layout->addRow(QStringLiteral("Scan focused windows every N milliseconds: "), focus_delay_);
 
+    // the delays above are the ceilings of the adaptive mode
+    adaptive_ = new QCheckBox{QStringLiteral("Scan faster after processes or the focus change")};
+    layout->addRow(adaptive_);
+
+    min_delay_ = new QSpinBox;
+    min_delay_->setMinimum(1);
+    min_delay_->setMaximum(std::numeric_limits<int>::max());
+    layout->addRow(QStringLiteral("Scan every N milliseconds after a change: "), min_delay_);
+    connect(adaptive_, &QCheckBox::toggled, min_delay_, &QSpinBox::setEnabled);
+
+    scan_workers_ = new QSpinBox;
+    scan_workers_->setMinimum(1);
+    scan_workers_->setMaximum(std::max(static_cast<int>(std::thread::hardware_concurrency()), 1));
+    layout->addRow(QStringLiteral("Scan new processes with N threads: "), scan_workers_);
+
+    // 0 writes every record as soon as it's sampled
+    flush_interval_ = new QSpinBox;
+    flush_interval_->setMinimum(0);
+    flush_interval_->setMaximum(std::numeric_limits<int>::max());
+    layout->addRow(QStringLiteral("Write records to the database every N seconds: "), flush_interval_);
+
+    // the order of items is stored in the settings
+    scan_scope_ = new QComboBox;
+    scan_scope_->addItem(QStringLiteral("All users"));
+    scan_scope_->addItem(QStringLiteral("Current user"));
+    scan_scope_->addItem(QStringLiteral("Cgroup"));
+    layout->addRow(QStringLiteral("Scan processes of: "), scan_scope_);
+
+    scan_cgroup_ = new QLineEdit;
+    scan_cgroup_->setPlaceholderText(QStringLiteral("/user.slice/user-1000.slice"));
+    layout->addRow(QStringLiteral("Cgroup: "), scan_cgroup_);
+    connect(scan_scope_, &QComboBox::currentIndexChanged, this, [this](int index) {
+        scan_cgroup_->setEnabled(index == 2);
+    });
+
+    // helpers are attributed to the nearest application whose executable (or directory ending with '/') is listed
+    fold_tree_ = new QCheckBox{QStringLiteral("Attribute helper processes to their application")};
+    layout->addRow(fold_tree_);
+
+    tree_roots_ = new QPlainTextEdit;
+    tree_roots_->setPlaceholderText(QStringLiteral("/usr/lib/firefox/\n/opt/google/chrome/chrome"));
+    layout->addRow(QStringLiteral("Applications (one per line): "), tree_roots_);
+    connect(fold_tree_, &QCheckBox::toggled, tree_roots_, &QPlainTextEdit::setEnabled);
+
     widget->setLayout(layout);
 
     listbox_->addItem(QStringLiteral("Monitoring"));
     widgets_->addWidget(widget);
 }
+
+void settings_window::initDiagnostics() {
+    auto *widget = new QWidget;
+    auto *layout = new QVBoxLayout;
+
+    // a row per stage of a sampler, the percentiles are the upper bounds of histogram buckets (within 1/16)
+    latencies_ = new QTableWidget;
+    latencies_->verticalHeader()->hide();
+    latencies_->setSelectionMode(QAbstractItemView::NoSelection);
+    latencies_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    latencies_->setColumnCount(8);
+    latencies_->setHorizontalHeaderLabels({"Sampler", "Stage", "Count", "Mean", "p50", "p90", "p99", "Max"});
+    latencies_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    layout->addWidget(latencies_);
+
+    diagnostics_timer_ = new QTimer{this};
+    diagnostics_timer_->setInterval(diagnostics_refresh);
+    connect(diagnostics_timer_, &QTimer::timeout, this, &settings_window::updateDiagnostics);
+    diagnostics_timer_->start();
+
+    widget->setLayout(layout);
+
+    listbox_->addItem(QStringLiteral("Diagnostics"));
+    widgets_->addWidget(widget);
+}
+
+void settings_window::updateDiagnostics() {
+    auto *window_ptr = qobject_cast<apptime::window *>(parent());
+    if (!window_ptr || !latencies_->isVisible()) {
+        return;
+    }
+
+    const auto latencies = window_ptr->monitor_.latencies();
+    latencies_->setRowCount(static_cast<int>(latencies.size()));
+    for (int i = 0; i < static_cast<int>(latencies.size()); i++) {
+        const auto                  &values = latencies[i].values;
+        const std::array<QString, 8> cells  = {
+            QString::fromStdString(latencies[i].sampler),
+            QString::fromStdString(latencies[i].stage),
+            QString::number(values.count),
+            format_latency(values.mean()),
+            format_latency(values.percentile(50)),
+            format_latency(values.percentile(90)),
+            format_latency(values.percentile(99)),
+            format_latency(values.max),
+        };
+        for (int column = 0; column < static_cast<int>(cells.size()); column++) {
+            latencies_->setItem(i, column, new QTableWidgetItem{cells[column]});
+        }
+    }
+}
 } // namespace apptime
\ No newline at end of file
@@ -1,9 +1,15 @@
 #ifndef APPTIME_GUI_SETTINGS_HPP
 #define APPTIME_GUI_SETTINGS_HPP
 
+#include <QCheckBox>
+#include <QComboBox>
+#include <QLineEdit>
 #include <QListWidget>
+#include <QPlainTextEdit>
 #include <QSpinBox>
 #include <QStackedWidget>
+#include <QTableWidget>
+#include <QTimer>
 #include <QWidget>
 
 namespace apptime {
@@ -21,9 +27,27 @@ protected:
 
 private:
     void initMonitoringSettings();
+    void initDiagnostics();
 
-    QSpinBox *active_delay_ = nullptr;
-    QSpinBox *focus_delay_  = nullptr;
+    // show the latencies of the samplers, it's called every second while the page is visible
+    void updateDiagnostics();
+
+    QSpinBox *active_delay_   = nullptr;
+    QSpinBox *focus_delay_    = nullptr;
+    QSpinBox *scan_workers_   = nullptr;
+    QSpinBox *flush_interval_ = nullptr;
+
+    QCheckBox *adaptive_  = nullptr;
+    QSpinBox  *min_delay_ = nullptr;
+
+    QComboBox *scan_scope_  = nullptr;
+    QLineEdit *scan_cgroup_ = nullptr;
+
+    QCheckBox      *fold_tree_  = nullptr;
+    QPlainTextEdit *tree_roots_ = nullptr;
+
+    QTableWidget *latencies_         = nullptr;
+    QTimer       *diagnostics_timer_ = nullptr;
 
     QListWidget    *listbox_ = nullptr;
     QStackedWidget *widgets_ = nullptr;
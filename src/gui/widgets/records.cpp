@@ -9,7 +9,7 @@
 #include <QHeaderView>
 #include <QMenu>
 
-#include "platforms/icon.hpp"
+#include "platforms/desktop.hpp"
 
 using apptime::table_records;
 
@@ -17,6 +17,10 @@ std::string application_name(const apptime::record &app, bool window_names = fal
     if (window_names && !app.name.empty()) {
         return app.name;
     }
+    // applications known to the desktop environment are shown by their display name, processes without a window too (e.g. on Wayland)
+    if (std::string name = apptime::application_display_name(app.path); !name.empty()) {
+        return name;
+    }
     const std::filesystem::path path{app.path};
     return path.filename().string();
 }
@@ -62,7 +66,7 @@ std::string duration_format(const table_records::app_duration_t &duration) {
 }
 
 namespace apptime {
-table_records::table_records(QWidget *parent) : QTableWidget{parent}, contextMenu_{new QMenu{"Context menu", this}} {
+table_records::table_records(QWidget *parent) : QTableWidget{parent}, contextMenu_{new QMenu{"Context menu", this}}, icons_{new icon_loader{this}} {
     setShowGrid(false);
     verticalHeader()->hide();
     setSelectionBehavior(QAbstractItemView::SelectItems);
@@ -75,12 +79,14 @@ table_records::table_records(QWidget *parent) : QTableWidget{parent}, contextMen
     horizontalHeaderItem(0)->setTextAlignment(Qt::AlignmentFlag::AlignLeft | Qt::AlignmentFlag::AlignVCenter);
 
     connect(this, &QTableWidget::customContextMenuRequested, this, &table_records::showContextMenu);
+    connect(icons_, &icon_loader::iconLoaded, this, &table_records::updateIcon);
 }
 
 void table_records::update(const std::vector<record> &apps, const settings &set) {
     clearContents();
 
-    list_ = convert_actives(apps, set.window_names);
+    list_      = convert_actives(apps, set.window_names);
+    showIcons_ = set.icons;
     setRowCount(static_cast<int>(list_.size()));
     for (int i = 0; i < static_cast<int>(list_.size()); i++) {
         const auto &element = list_[i];
@@ -89,7 +95,8 @@ void table_records::update(const std::vector<record> &apps, const settings &set)
         name->setFlags(name->flags() & ~Qt::ItemIsEditable);
         setItem(i, 0, name);
         if (set.icons) {
-            name->setIcon(application_icon(element.path));
+            // icons that aren't cached yet are set by updateIcon
+            name->setIcon(icons_->icon(element.path));
         }
 
         const std::string total_str = duration_format(element.duration);
@@ -135,6 +142,18 @@ void table_records::showContextMenu(const QPoint &pos) {
     contextMenu_->exec(mapToGlobal(pos));
 }
 
+void table_records::updateIcon(const QString &path, const QIcon &icon) {
+    if (!showIcons_) {
+        return;
+    }
+    const std::string key = path.toStdString();
+    for (int i = 0; i < static_cast<int>(list_.size()); i++) {
+        if (QTableWidgetItem *name = item(i, 0); name && list_[i].path == key) {
+            name->setIcon(icon);
+        }
+    }
+}
+
 void table_records::loadStyle() {
     QFile style_file{":/styles/records.qss"};
     style_file.open(QFile::ReadOnly);
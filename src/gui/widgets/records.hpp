@@ -6,6 +6,7 @@
 #include <QTableWidget>
 
 #include "database/database.hpp"
+#include "gui/icon_loader.hpp"
 
 namespace apptime {
 class table_records : public QTableWidget {
@@ -35,12 +36,15 @@ signals:
 
 private slots:
     void showContextMenu(const QPoint &pos);
+    void updateIcon(const QString &path, const QIcon &icon);
 
 private:
     void loadStyle();
 
     QMenu                  *contextMenu_ = nullptr;
+    icon_loader            *icons_       = nullptr;
     std::vector<table_info> list_;
+    bool                    showIcons_ = false;
 };
 } // namespace apptime
 
@@ -1,5 +1,7 @@
 #include "window.hpp"
 
+#include <cstdlib>
+
 #include <QCloseEvent>
 #include <QCoreApplication>
 #include <QFormLayout>
@@ -15,11 +17,41 @@
 #include "gui/ignore.hpp"
 #include "process/process_system.hpp"
 
+#ifdef __linux__
+#include "process/process_netlink.hpp"
+using process_default_mgr = apptime::process_netlink_mgr;
+#else
+using process_default_mgr = apptime::process_system_mgr;
+#endif
+
+#ifdef APPTIME_X11_IDLE
+#include "process/x11_idle.hpp"
+#endif
+#ifdef APPTIME_LOGIND
+#include "process/logind_idle.hpp"
+#endif
+
+// the screen saver of X11 knows the input of all applications, except native Wayland clients under XWayland
+std::unique_ptr<apptime::idle_detector> default_idle_detector() {
+#ifdef APPTIME_X11_IDLE
+    if (!std::getenv("WAYLAND_DISPLAY")) { // NOLINT(concurrency-mt-unsafe)
+        if (auto detector = apptime::x11_idle::connect()) {
+            return detector;
+        }
+    }
+#endif
+#ifdef APPTIME_LOGIND
+    return apptime::logind_idle::connect();
+#else
+    return nullptr;
+#endif
+}
+
 namespace apptime {
 window::window(QWidget *parent)
     : QMainWindow{parent},
       db_{std::make_shared<database_sqlite>("./result.db")},
-      monitor_{db_, std::make_unique<process_system_mgr>()} {
+      monitor_{db_, std::make_unique<process_default_mgr>(), default_idle_detector()} {
     const QIcon icon{":/icon.png"};
     setWindowIcon(icon);
 
@@ -0,0 +1,113 @@
+#ifndef APPTIME_LATENCY_HISTOGRAM_HPP
+#define APPTIME_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace apptime {
+/**
+ * @brief A lock-free histogram of durations with buckets of logarithmic width (like HdrHistogram).
+ *
+ * Every power of two of nanoseconds is split into 16 buckets of equal width, so a value is known with an error below 1/16
+ * from 1 ns up to the maximum (about 18 minutes), longer durations are counted as the maximum.
+ * Recording is a few relaxed atomic additions, it can be called by any thread while another thread reads a snapshot.
+ */
+class latency_histogram {
+public:
+    using duration = std::chrono::nanoseconds;
+
+    /// @brief The number of bits of a value that select its bucket within its power of two.
+    static constexpr unsigned    sub_bits     = 4;
+    static constexpr unsigned    max_bits     = 40;
+    static constexpr std::size_t bucket_count = std::size_t{max_bits - sub_bits + 1} << sub_bits;
+
+    /// @brief The counts of a histogram at a point in time.
+    struct snapshot {
+        std::uint64_t              count = 0;
+        duration                   total{0};
+        duration                   max{0};
+        std::vector<std::uint64_t> buckets;
+
+        duration mean() const { return count > 0 ? total / static_cast<duration::rep>(count) : duration{0}; }
+
+        /**
+         * @brief Get the value below which a percentage of the recorded values is.
+         *
+         * @param percent The percentage from 0 to 100.
+         * @return duration The highest value of the bucket of the percentile (0 if nothing is recorded).
+         */
+        duration percentile(double percent) const {
+            const auto    rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(percent / 100 * static_cast<double>(count))));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < buckets.size(); i++) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    return std::min(duration{static_cast<duration::rep>(bucket_end(i))}, max);
+                }
+            }
+            return max;
+        }
+    };
+
+    void record(duration value) {
+        const auto ns = static_cast<std::uint64_t>(std::clamp<duration::rep>(value.count(), 0, max_value));
+        buckets_[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(ns, std::memory_order_relaxed);
+        std::uint64_t max = max_.load(std::memory_order_relaxed);
+        while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Read the counts, it can be called by any thread.
+     *
+     * The counts aren't read atomically as a whole, a value recorded during the call may miss the total or the maximum.
+     */
+    snapshot read() const {
+        snapshot result;
+        result.buckets.resize(bucket_count);
+        for (std::size_t i = 0; i < bucket_count; i++) {
+            result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            result.count += result.buckets[i];
+        }
+        result.total = duration{static_cast<duration::rep>(total_.load(std::memory_order_relaxed))};
+        result.max   = duration{static_cast<duration::rep>(max_.load(std::memory_order_relaxed))};
+        return result;
+    }
+
+    /// @brief The bucket of a value in nanoseconds, values below 16 have a bucket each.
+    static constexpr std::size_t bucket(std::uint64_t value) {
+        if (value < (1U << sub_bits)) {
+            return value;
+        }
+        const unsigned shift = std::bit_width(value) - sub_bits - 1;
+        return (std::size_t{shift + 1} << sub_bits) + (value >> shift) - (1U << sub_bits);
+    }
+
+    /// @brief The highest value in nanoseconds of a bucket.
+    static constexpr std::uint64_t bucket_end(std::size_t index) {
+        if (index < (1U << sub_bits)) {
+            return index;
+        }
+        const std::size_t shift = (index >> sub_bits) - 1;
+        const std::size_t sub   = index & ((1U << sub_bits) - 1);
+        return (((std::uint64_t{sub} + (1U << sub_bits)) + 1) << shift) - 1;
+    }
+
+private:
+    static constexpr duration::rep max_value = (duration::rep{1} << max_bits) - 1;
+
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets_{};
+    std::atomic<std::uint64_t>                           total_{0};
+    std::atomic<std::uint64_t>                           max_{0};
+};
+} // namespace apptime
+
+#endif // APPTIME_LATENCY_HISTOGRAM_HPP
\ No newline at end of file
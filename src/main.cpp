@@ -2,12 +2,16 @@
 
 #include "gui/tray.hpp"
 #include "gui/window.hpp"
+#include "platforms/desktop.hpp"
 
 int main(int argc, char *argv[]) {
     QCoreApplication::setOrganizationName("imring");
     QCoreApplication::setOrganizationDomain("imring.dev");
     QCoreApplication::setApplicationName("apptime");
 
+    // desktop entries are loaded while the window is created
+    apptime::load_desktop_entries();
+
     const QApplication app{argc, argv};
     apptime::window    window;
     apptime::tray      tray_icon{&window};
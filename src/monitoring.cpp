@@ -1,8 +1,9 @@
 #include "monitoring.hpp"
+#include "sampling.hpp"
 
-#include <ranges>
+#include <algorithm>
+#include <span>
 #include <thread>
-#include <unordered_map>
 #include <utility>
 
 using namespace std::chrono_literals;
@@ -10,70 +11,111 @@ using namespace std::chrono_literals;
 constexpr std::chrono::milliseconds default_active_delay = 5s;
 constexpr std::chrono::milliseconds default_focus_delay  = 1s;
 
-using apptime::process_mgr;
+// a batch is written every 30 seconds, so the disk isn't synced for every record of every cycle
+constexpr std::chrono::milliseconds default_flush_interval = 30s;
+constexpr std::size_t               default_flush_records  = 512;
 
-// monitoring writes processes that have a window. among identical processes writes the oldest.
-std::vector<process_mgr::process_type> filtered_windows(process_mgr *manager) {
-    std::unordered_map<std::string, process_mgr::process_type> result;
-    for (auto &win: manager->active_windows(true)) {
-        const std::string path = win->full_path();
-        if (path.empty()) {
-            continue;
-        }
+// an open interval is rewritten once a minute instead of every cycle
+constexpr std::chrono::milliseconds default_checkpoint_interval = 1min;
 
-        const auto it = result.find(path);
-        if (it == result.end()) {
-            // write a new process
-            result.emplace(path, std::move(win));
-            continue;
-        }
+// the delay of the adaptive mode after a change, it's doubled up to active_delay or focus_delay
+constexpr std::chrono::milliseconds default_min_delay = 250ms;
 
-        // select the oldest process
-        if (win->start() > it->second->start()) {
-            it->second = std::move(win);
-        }
-    }
+// the samplers due within 20 ms of a wakeup run in it
+constexpr std::chrono::milliseconds sampler_slack = 20ms;
 
-    const auto values = result | std::views::values;
-    return std::vector<process_mgr::process_type>{std::make_move_iterator(values.begin()), std::make_move_iterator(values.end())};
-}
-
-apptime::record build_record(std::unique_ptr<apptime::process> proc, bool focused = false) {
-    apptime::record result;
-    result.name = proc->window_name();
-    result.path = proc->full_path();
-    result.times.emplace_back(focused ? proc->focused_start() : proc->start(), std::chrono::system_clock::now());
-    return result;
-}
+// the capacities of the queues to the writer thread, the active thread pushes a record per application every cycle
+constexpr std::size_t active_queue_capacity = 4096;
+constexpr std::size_t focus_queue_capacity  = 256;
+constexpr std::size_t exit_queue_capacity   = 256;
 
 namespace apptime {
-monitoring::monitoring(std::shared_ptr<database> db, std::unique_ptr<process_mgr> manager)
+monitoring::monitoring(std::shared_ptr<database> db, std::unique_ptr<process_mgr> manager, std::unique_ptr<idle_detector> idle)
     : active_delay{default_active_delay},
       focus_delay{default_focus_delay},
+      scan_workers{1},
+      flush_interval{default_flush_interval},
+      flush_records{default_flush_records},
+      checkpoint_interval{default_checkpoint_interval},
+      adaptive{false},
+      min_delay{default_min_delay},
+      scheduler_{sampler_slack},
       db_{std::move(db)},
       manager_{std::move(manager)},
-      running_{false} {}
+      idle_detector_{std::move(idle)},
+      running_{false},
+      active_queue_{active_queue_capacity},
+      focus_queue_{focus_queue_capacity},
+      exit_queue_{exit_queue_capacity},
+      writing_{false},
+      watcher_{[this](int pid, std::chrono::system_clock::time_point exit_time) {
+          process_exited(pid, exit_time);
+      }} {
+    scheduler_.add("active", [this] {
+        return active_cycle();
+    });
+    focus_task_ = scheduler_.add("focus", [this] {
+        return focus_cycle();
+    });
+}
 
 monitoring::~monitoring() {
     stop();
 }
 
 void monitoring::start() {
-    running_       = true;
-    active_thread_ = std::thread{&monitoring::active_thread, this};
-    focus_thread_  = std::thread{&monitoring::focus_thread, this};
+    // the adaptive delays start at the minimum
+    active_poll_.delay = 0;
+    focus_poll_.delay  = 0;
+
+    // the detector reports the current state again when the callback is set
+    idle_               = false;
+    focus_idle_         = false;
+    focus_checkpointed_ = std::chrono::steady_clock::now();
+    running_            = true;
+    writing_            = true;
+    writer_thread_      = std::thread{&monitoring::writer_thread, this};
+
+    // if the manager reports focus changes, the focus sampler sleeps until the focus actually changes
+    focus_events_ = manager_->on_focus_change([this] {
+        scheduler_.wake(focus_task_);
+    });
+    if (idle_detector_) {
+        idle_detector_->on_idle_change([this](bool idle, std::chrono::system_clock::time_point since) {
+            {
+                const std::lock_guard<std::mutex> lock{mutex_};
+                idle_       = idle;
+                idle_since_ = since;
+            }
+            scheduler_.wake(focus_task_);
+        });
+    }
+    scheduler_.start();
 }
 
 void monitoring::stop() {
     running_ = false;
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        watcher_.clear();
+        tracked_.clear();
+    }
 
-    // this is needed to stop threads immediately
-    cv.notify_all();
-    if (active_thread_.joinable()) {
-        active_thread_.join();
+    // the running sampler finishes its cycle
+    scheduler_.stop();
+    if (writer_thread_.joinable()) {
+        manager_->on_focus_change({});
+        if (idle_detector_) {
+            idle_detector_->on_idle_change({});
+        }
+        close_intervals();
     }
-    if (focus_thread_.joinable()) {
-        focus_thread_.join();
+
+    // the samplers are stopped, the writer writes the remaining records and returns
+    writing_ = false;
+    notify_writer();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
     }
 }
 
@@ -81,37 +123,420 @@ bool monitoring::running() const {
     return running_;
 }
 
-void monitoring::active_thread() {
-    for (;;) {
-        // write active processes
-        std::unique_lock<std::mutex> lock{mutex_};
-        for (auto &proc: filtered_windows(manager_.get())) {
-            db_->add_active(build_record(std::move(proc)));
+void monitoring::scan_scope(const process_scope &scope) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    scan_scope_ = scope;
+}
+
+process_scope monitoring::scan_scope() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    return scan_scope_;
+}
+
+void monitoring::tree_roots(std::vector<std::string> roots) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    tree_roots_ = std::move(roots);
+}
+
+std::vector<std::string> monitoring::tree_roots() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    return tree_roots_;
+}
+
+monitoring::writer_stats monitoring::stats() const {
+    return {.active = active_queue_.stats(), .focus = focus_queue_.stats(), .exits = exit_queue_.stats(), .pending = pending_.load()};
+}
+
+monitoring::poll_stats monitoring::polling() const {
+    return {.active = active_poll_.stats(), .focus = focus_poll_.stats()};
+}
+
+std::vector<monitoring::latency_stats> monitoring::latencies() const {
+    return {
+        {.sampler = "active", .stage = "scan", .values = active_latency_.scan.read()},
+        {.sampler = "active", .stage = "dedup", .values = active_latency_.dedup.read()},
+        {.sampler = "active", .stage = "lock wait", .values = active_latency_.lock_wait.read()},
+        {.sampler = "active", .stage = "cycle", .values = active_latency_.cycle.read()},
+        {.sampler = "focus", .stage = "scan", .values = focus_latency_.scan.read()},
+        {.sampler = "focus", .stage = "lock wait", .values = focus_latency_.lock_wait.read()},
+        {.sampler = "focus", .stage = "cycle", .values = focus_latency_.cycle.read()},
+        {.sampler = "writer", .stage = "journal", .values = journal_latency_.read()},
+        {.sampler = "writer", .stage = "write", .values = write_latency_.read()},
+    };
+}
+
+std::unique_lock<std::mutex> monitoring::lock_mutex(latency_histogram &wait) {
+    const auto                   started = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock{mutex_};
+    wait.record(std::chrono::steady_clock::now() - started);
+    return lock;
+}
+
+std::vector<scheduler::task_stats> monitoring::sampler_stats() const {
+    return scheduler_.stats();
+}
+
+scheduler::clock::duration monitoring::active_cycle() {
+    const auto started = scheduler::clock::now();
+
+    // changing the scope drops the process table of the manager, so it's applied only when it differs.
+    // the settings are compared under the lock and aren't copied, so unchanged settings don't allocate memory
+    auto       settings_lock = lock_mutex(active_latency_.lock_wait);
+    const bool scope_changed = scan_scope_ != applied_scope_;
+    if (scope_changed) {
+        applied_scope_ = scan_scope_;
+    }
+    if (tree_roots_ != tree_.roots()) {
+        tree_.roots(tree_roots_);
+    }
+    settings_lock.unlock();
+    if (scope_changed) {
+        manager_->scan_scope(applied_scope_);
+    }
+
+    // sample and filter processes without the lock, so a long scan doesn't block the exit watcher
+    manager_->scan_workers(scan_workers);
+    const auto sampling = std::chrono::steady_clock::now();
+    manager_->snapshot(true, buffer_);
+    const auto sampled = std::chrono::steady_clock::now();
+    active_latency_.scan.record(sampled - sampling);
+    const auto processes = filter_windows(buffer_, tree_);
+    active_latency_.dedup.record(std::chrono::steady_clock::now() - sampled);
+
+    // update the sessions of active processes, the writer gets only opened and checkpointed sessions.
+    // an opened or closed session is a change of the process set
+    auto lock = lock_mutex(active_latency_.lock_wait);
+    cycle_++;
+    const auto now     = std::chrono::steady_clock::now();
+    bool       changed = std::exchange(exited_, false);
+    for (const auto &entry: processes) {
+        active_session &session = sessions_[entry.pid];
+        if (session.samples > 0 && session.start != entry.start) { // the process ID is reused
+            close_session(session);
+        }
+        build_record(entry, session.rec);
+        add_usage(entry, session);
+        changed = changed || session.samples == 1;
+        if (session.samples == 1 || now - session.pushed >= checkpoint_interval) {
+            push_session(session, now);
+        } else {
+            session.dirty = true;
         }
+    }
 
-        // wait for next cycle
-        // if monitoring is stopped, return
-        if (cv.wait_for(lock, active_delay, [this] {
-                return !running();
-            })) {
-            return;
+    // the sessions of processes that aren't written anymore are closed at their last sample
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (it->second.cycle == cycle_) {
+            ++it;
+            continue;
         }
+        close_session(it->second);
+        it      = sessions_.erase(it);
+        changed = true;
+    }
+    notify_writer();
+    track_exits(processes);
+
+    active_latency_.cycle.record(scheduler::clock::now() - started);
+    return active_poll_.next(changed, adaptive, min_delay, active_delay);
+}
+
+std::chrono::milliseconds monitoring::poll_state::next(bool changed, bool adaptive, std::chrono::milliseconds min, std::chrono::milliseconds max) {
+    using std::chrono::milliseconds;
+
+    // the first poll sees all processes as new, it isn't counted
+    const milliseconds previous{delay.load(std::memory_order_relaxed)};
+    if (changed && previous.count() > 0) {
+        (previous <= min ? caught : missed).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    milliseconds result = max;
+    if (adaptive) {
+        result = std::min(changed || previous.count() == 0 ? min : previous * 2, max);
+    }
+    delay.store(result.count(), std::memory_order_relaxed);
+    return result;
+}
+
+monitoring::polling_stats monitoring::poll_state::stats() const {
+    return {.delay = std::chrono::milliseconds{delay.load()}, .caught = caught.load(), .missed = missed.load()};
+}
+
+void monitoring::add_usage(const process_entry &entry, active_session &session) {
+    if (session.samples == 0 || session.start != entry.start) { // a new interval, the record keeps its memory
+        session.start         = entry.start;
+        session.cpu_time      = entry.cpu_time;
+        session.last_cpu_time = entry.cpu_time;
+        session.rss_peak      = 0;
+        session.rss_sum       = 0;
+        session.samples       = 0;
+        session.dirty         = false;
+    }
+
+    // processes of the application that exited between samples decrease the sum, only the growth is counted
+    if (entry.cpu_time > session.last_cpu_time) {
+        session.cpu_time += entry.cpu_time - session.last_cpu_time;
     }
+    session.last_cpu_time = entry.cpu_time;
+    session.rss_peak      = std::max(session.rss_peak, entry.rss);
+    session.rss_sum += entry.rss;
+    session.samples++;
+    session.cycle = cycle_;
+
+    fill_usage(session, session.rec);
+}
+
+void monitoring::fill_usage(const active_session &session, record &rec) {
+    rec.cpu_time = session.cpu_time;
+    rec.rss_peak = session.rss_peak;
+    rec.rss_avg  = session.samples > 0 ? session.rss_sum / session.samples : 0;
 }
 
-void monitoring::focus_thread() {
+void monitoring::push_session(active_session &session, std::chrono::steady_clock::time_point now) {
+    record *rec = next_record(active_queue_);
+    if (rec) {
+        *rec = session.rec;
+        active_queue_.records.push();
+    }
+    // a dropped record is passed again when the session closes
+    session.dirty  = rec == nullptr;
+    session.pushed = now;
+}
+
+void monitoring::close_session(active_session &session) {
+    if (session.dirty) {
+        push_session(session, std::chrono::steady_clock::now());
+    }
+}
+
+void monitoring::track_exits(std::span<const process_entry> processes) {
+    // stop waiting for processes that are no longer written
+    std::erase_if(tracked_, [this, &processes](const auto &pair) {
+        const bool written = std::ranges::any_of(processes, [pid = pair.first](const process_entry &entry) {
+            return entry.pid == pid;
+        });
+        if (!written) {
+            watcher_.unwatch(pair.first);
+        }
+        return !written;
+    });
+
+    for (const auto &entry: processes) {
+        if (!tracked_.contains(entry.pid) && watcher_.watch(entry.pid)) {
+            tracked_.emplace(entry.pid, process_info{
+                                            .pid          = entry.pid,
+                                            .window_name  = std::string{entry.window_name},
+                                            .name_version = entry.name_version,
+                                            .full_path    = std::string{entry.full_path},
+                                            .exe_id       = entry.exe_id,
+                                            .exe          = entry.exe,
+                                            .start        = entry.start,
+                                        });
+        }
+    }
+}
+
+void monitoring::process_exited(int pid, std::chrono::system_clock::time_point exit_time) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+
+    const auto it = tracked_.find(pid);
+    if (it == tracked_.end() || !running()) {
+        return;
+    }
+
+    // close the interval at the exit time instead of waiting for the next cycle, it's written with the usage of the session
+    record rec = build_record(std::move(it->second));
+    tracked_.erase(it);
+    rec.times.back().second = exit_time;
+    if (const auto session = sessions_.find(pid); session != sessions_.end() && session->second.start == rec.times.back().first) {
+        fill_usage(session->second, rec);
+        sessions_.erase(session);
+    }
+    if (record *slot = next_record(exit_queue_)) {
+        *slot = std::move(rec);
+        exit_queue_.records.push();
+        notify_writer();
+    }
+    exited_ = true;
+}
+
+scheduler::clock::duration monitoring::focus_cycle() {
+    const auto started = scheduler::clock::now();
+    auto       lock    = lock_mutex(focus_latency_.lock_wait);
+    if (idle_) {
+        // close the interval at the last input, nothing is written until the detector wakes the sampler up
+        if (!focus_last_.path.empty()) {
+            focus_last_.times.back().second = std::max(focus_last_.times.back().first, idle_since_);
+            write_focus(focus_last_);
+            focus_last_  = {};
+            focus_dirty_ = false;
+        }
+        focus_idle_ = true;
+        focus_latency_.cycle.record(scheduler::clock::now() - started);
+        return scheduler::never;
+    }
+    if (std::exchange(focus_idle_, false)) {
+        resumed_ = idle_since_;
+    }
+    const auto resumed = resumed_;
+    lock.unlock();
+
+    // write a focused process, the manager is queried without the lock
+    const auto scanning = std::chrono::steady_clock::now();
+    record     rec      = build_record(manager_->focused_window(), true);
+    auto      &start    = rec.times.front().first;
+    start               = std::max(start, resumed);
+    focus_latency_.scan.record(std::chrono::steady_clock::now() - scanning);
+
+    const bool opened = focus_last_.path.empty() || focus_last_.path != rec.path || focus_last_.times.front().first != start;
+    if (opened && !focus_last_.path.empty() && (focus_events_ || focus_dirty_)) {
+        // close the previous interval at the time the focus changed, or at its last sample without focus events
+        if (focus_events_) {
+            focus_last_.times.back().second = start;
+        }
+        write_focus(focus_last_);
+    }
+    const auto now = std::chrono::steady_clock::now();
+    focus_dirty_   = !opened && now - focus_checkpointed_ < checkpoint_interval;
+    if (!focus_dirty_) {
+        write_focus(rec);
+        focus_checkpointed_ = now;
+    }
+    focus_last_ = std::move(rec);
+
+    // with focus events the sampler runs again when the focus changes, or at the checkpoint
+    scheduler::clock::duration delay = scheduler::never;
+    if (!focus_events_) {
+        delay = focus_poll_.next(opened, adaptive, min_delay, focus_delay);
+    } else if (checkpoint_interval > 0ms) {
+        delay = checkpoint_interval;
+    }
+    focus_latency_.cycle.record(scheduler::clock::now() - started);
+    return delay;
+}
+
+void monitoring::write_focus(const record &rec) {
+    if (record *slot = next_record(focus_queue_)) {
+        *slot = rec;
+        focus_queue_.records.push();
+        notify_writer();
+    }
+}
+
+void monitoring::close_intervals() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    for (auto &[pid, session]: sessions_) {
+        close_session(session);
+    }
+    sessions_.clear();
+
+    // with focus events the window is focused until now, otherwise it was focused at the last sample
+    if (!focus_last_.path.empty() && (focus_events_ || focus_dirty_)) {
+        if (focus_events_) {
+            focus_last_.times.back().second = std::chrono::system_clock::now();
+        }
+        write_focus(focus_last_);
+    }
+    focus_last_  = {};
+    focus_dirty_ = false;
+    notify_writer();
+}
+
+void monitoring::writer_thread() {
+    // the records of a pass and the records waiting for the flush, they are reused by every pass
+    std::vector<record> actives;
+    std::vector<record> focuses;
+    record_batch        batch;
+    auto                flushed = std::chrono::steady_clock::now();
+
     for (;;) {
-        // write a focused process
-        std::unique_lock<std::mutex> lock{mutex_};
-        db_->add_focus(build_record(manager_->focused_window(), true));
-
-        // wait for next cycle
-        // if monitoring is stopped, return
-        if (cv.wait_for(lock, focus_delay, [this] {
-                return !running();
-            })) {
+        // the counter is read before the queues, so records pushed during the pass wake the thread up again
+        const std::uint64_t pushed  = pushed_.load();
+        const bool          writing = writing_;
+
+        // exits are counted before the samples are read: an exit is pushed after the samples of its interval,
+        // so they are read first and don't overwrite the end of the interval
+        actives.clear();
+        focuses.clear();
+        std::size_t exits = exit_queue_.records.size();
+        for (record *rec = active_queue_.records.front(); rec; rec = active_queue_.records.front()) {
+            actives.push_back(*rec);
+            active_queue_.records.pop();
+        }
+        for (; exits > 0; exits--) {
+            actives.push_back(*exit_queue_.records.front());
+            exit_queue_.records.pop();
+        }
+        for (record *rec = focus_queue_.records.front(); rec; rec = focus_queue_.records.front()) {
+            focuses.push_back(*rec);
+            focus_queue_.records.pop();
+        }
+
+        // the batch is written when monitoring stops, when it's big or old enough, or when the records can't be journaled.
+        // the thread is woken up by every cycle of the active sampler, so the interval is checked at least that often
+        const auto now   = std::chrono::steady_clock::now();
+        bool       flush = !writing || flush_interval <= 0ms || now - flushed >= flush_interval ||
+                     batch.size() + actives.size() + focuses.size() >= flush_records;
+        if (!flush && (!actives.empty() || !focuses.empty())) {
+            flush = !db_->journal(actives, focuses);
+            journal_latency_.record(std::chrono::steady_clock::now() - now);
+        }
+
+        for (const auto &rec: actives) {
+            batch.add(rec, false);
+        }
+        for (const auto &rec: focuses) {
+            batch.add(rec, true);
+        }
+        if (flush) {
+            if (batch.size() > 0) {
+                const auto started = std::chrono::steady_clock::now();
+                db_->add_records(batch.actives, batch.focuses);
+                write_latency_.record(std::chrono::steady_clock::now() - started);
+            }
+            batch.clear();
+            flushed = now;
+        }
+        pending_ = batch.size();
+
+        if (!writing) {
             return;
         }
+        pushed_.wait(pushed);
+    }
+}
+
+void monitoring::record_batch::add(const record &rec, bool focus) {
+    std::vector<record> &records = focus ? focuses : actives;
+    if (rec.times.empty()) {
+        records.push_back(rec);
+        return;
+    }
+
+    const auto [it, inserted] = index.try_emplace({focus, rec.path, rec.times.front().first}, records.size());
+    if (inserted) {
+        records.push_back(rec);
+    } else {
+        records[it->second] = rec;
     }
 }
+
+void monitoring::record_batch::clear() {
+    actives.clear();
+    focuses.clear();
+    index.clear();
+}
+
+record *monitoring::next_record(record_queue &queue) {
+    record *result = queue.records.back();
+    if (!result) {
+        queue.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void monitoring::notify_writer() {
+    pushed_.fetch_add(1);
+    pushed_.notify_one();
+}
 } // namespace apptime
\ No newline at end of file
@@ -3,16 +3,28 @@
 
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
+#include <cstdint>
+#include <map>
 #include <mutex>
+#include <span>
+#include <string>
+#include <tuple>
+#include <unordered_map>
 
 #include "database/database.hpp"
+#include "latency_histogram.hpp"
+#include "process/exit_watcher.hpp"
+#include "process/idle_detector.hpp"
 #include "process/process.hpp"
+#include "process/process_tree.hpp"
+#include "scheduler.hpp"
+#include "spsc_queue.hpp"
 
 namespace apptime {
 class monitoring {
 public:
-    monitoring(std::shared_ptr<database> db, std::unique_ptr<process_mgr> manager);
+    // the focus isn't written while the detector reports that the user is away (nullptr to write it all the time)
+    monitoring(std::shared_ptr<database> db, std::unique_ptr<process_mgr> manager, std::unique_ptr<idle_detector> idle = nullptr);
     ~monitoring();
 
     void start();
@@ -21,20 +33,227 @@ public:
     bool running() const;
 
     std::chrono::milliseconds active_delay, focus_delay; // NOLINT
+    unsigned                  scan_workers;              // NOLINT
+
+    // records are written by one transaction every flush interval or when flush_records records wait,
+    // in between they are saved to the journal of the database. the interval 0 or a database without a journal
+    // writes records as soon as they are sampled. the statistics read from the database lag by up to the interval
+    std::chrono::milliseconds flush_interval; // NOLINT
+    std::size_t               flush_records;  // NOLINT
+
+    // an interval is passed to the writer when it opens and when it closes, while it's open it's kept in memory
+    // and passed again every checkpoint interval, which bounds the time lost by a crash. the interval 0 passes every sample
+    std::chrono::milliseconds checkpoint_interval; // NOLINT
+
+    // in the adaptive mode a sampler waits min_delay after it sees a change and doubles the delay after every poll
+    // without one, up to active_delay or focus_delay. otherwise the samplers always wait active_delay and focus_delay
+    bool                      adaptive;  // NOLINT
+    std::chrono::milliseconds min_delay; // NOLINT
+
+    // the scope is applied by the active sampler before the next scan
+    void          scan_scope(const process_scope &scope);
+    process_scope scan_scope();
+
+    // attribute helper processes to the applications whose executables match the rules (see process_tree), empty to disable
+    void                     tree_roots(std::vector<std::string> roots);
+    std::vector<std::string> tree_roots();
+
+    // the state of a queue of records to the writer thread, records are dropped when the queue is full
+    struct queue_stats {
+        std::size_t   depth    = 0;
+        std::size_t   capacity = 0;
+        std::uint64_t dropped  = 0;
+    };
+    struct writer_stats {
+        queue_stats active;
+        queue_stats focus;
+        queue_stats exits;
+        // records waiting for the next flush
+        std::size_t pending = 0;
+    };
+    writer_stats stats() const;
+
+    // the delay of a sampler before its next poll (0 before the first poll or if the sampler waits for events).
+    // a change seen after a delay of min_delay is caught, a change seen after a longer delay is missed:
+    // it happened up to that delay before it was seen
+    struct polling_stats {
+        std::chrono::milliseconds delay{0};
+        std::uint64_t             caught = 0;
+        std::uint64_t             missed = 0;
+    };
+    struct poll_stats {
+        polling_stats active;
+        polling_stats focus;
+    };
+    poll_stats polling() const;
+
+    // the lateness of the samplers, they run by one scheduler thread with absolute deadlines
+    std::vector<scheduler::task_stats> sampler_stats() const;
+
+    // the latencies of a stage of a sampler or of the writer since monitoring was constructed.
+    // the samplers record the scan of the processes, the deduplication of the applications, the wait for the mutex
+    // and the whole cycle, the writer records the journal appends and the database writes
+    struct latency_stats {
+        std::string                 sampler;
+        std::string                 stage;
+        latency_histogram::snapshot values;
+    };
+    std::vector<latency_stats> latencies() const;
 
 private:
-    void active_thread();
-    void focus_thread();
+    // records of one producer (the samplers, the exit watcher) to the writer thread
+    struct record_queue {
+        explicit record_queue(std::size_t capacity) : records{capacity} {}
+
+        spsc_queue<record>         records;
+        std::atomic<std::uint64_t> dropped{0};
+
+        queue_stats stats() const { return {.depth = records.size(), .capacity = records.capacity(), .dropped = dropped.load()}; }
+    };
+
+    // records written by the next flush. the active sampler pushes the growing interval of an application every cycle,
+    // so a record replaces the previous record of the same interval
+    struct record_batch {
+        std::vector<record>                                                                          actives;
+        std::vector<record>                                                                          focuses;
+        std::map<std::tuple<bool, std::string, std::chrono::system_clock::time_point>, std::size_t> index;
+
+        void        add(const record &rec, bool focus);
+        std::size_t size() const { return actives.size() + focuses.size(); }
+        void        clear();
+    };
+
+    // the delay of a sampler, it's updated by the sampler and read by `polling`
+    struct poll_state {
+        std::atomic<std::chrono::milliseconds::rep> delay{0};
+        std::atomic<std::uint64_t>                  caught{0};
+        std::atomic<std::uint64_t>                  missed{0};
+
+        // count a poll and get the delay before the next one, min is the delay after a change and max the ceiling
+        std::chrono::milliseconds next(bool changed, bool adaptive, std::chrono::milliseconds min, std::chrono::milliseconds max);
+        polling_stats             stats() const;
+    };
+
+    // an open interval of a written process. the record is filled by every cycle, the resource usage is aggregated
+    // in memory between cycles and written with the interval
+    struct active_session {
+        record                                rec;
+        std::chrono::steady_clock::time_point pushed;
+        // the record changed since it was passed to the writer
+        bool dirty = false;
+
+        std::chrono::system_clock::time_point start;
+        std::chrono::milliseconds             cpu_time{0};
+        std::chrono::milliseconds             last_cpu_time{0};
+        std::uint64_t                         rss_peak = 0;
+        std::uint64_t                         rss_sum  = 0;
+        std::uint64_t                         samples  = 0;
+        std::uint64_t                         cycle    = 0;
+    };
+
+    // the latencies recorded by a sampler, the focus sampler doesn't deduplicate
+    struct cycle_latency {
+        latency_histogram scan;
+        latency_histogram dedup;
+        latency_histogram lock_wait;
+        latency_histogram cycle;
+    };
+
+    // lock the mutex and record the wait
+    std::unique_lock<std::mutex> lock_mutex(latency_histogram &wait);
+
+    // the samplers run by the scheduler, they return the delay before their next run
+    scheduler::clock::duration active_cycle();
+    scheduler::clock::duration focus_cycle();
+    void                       writer_thread();
+
+    // pass a focus record to the writer
+    void write_focus(const record &rec);
+    // close the open intervals at their last samples after the scheduler is stopped
+    void close_intervals();
+
+    // get the slot of the next record of a queue, nullptr if the queue is full and the record is dropped
+    static record *next_record(record_queue &queue);
+    // wake up the writer thread after records are pushed
+    void notify_writer();
+
+    // add a sample of the written process to its interval and copy the aggregated usage to the record
+    void        add_usage(const process_entry &entry, active_session &session);
+    static void fill_usage(const active_session &session, record &rec);
+
+    // pass the record of a session to the writer, a closed session is passed only if it changed since the last time
+    void push_session(active_session &session, std::chrono::steady_clock::time_point now);
+    void close_session(active_session &session);
+
+    // write the final record of an application as soon as its process exits
+    void track_exits(std::span<const process_entry> processes);
+    void process_exited(int pid, std::chrono::system_clock::time_point exit_time);
+
+    scheduler   scheduler_;
+    std::size_t focus_task_ = 0;
+    std::thread writer_thread_;
+
+    std::shared_ptr<database>      db_;
+    std::unique_ptr<process_mgr>   manager_;
+    std::unique_ptr<idle_detector> idle_detector_;
+
+    // guards the state shared by the samplers, the exit watcher and the callbacks, it's never held during database writes
+    std::mutex       mutex_;
+    std::atomic_bool running_;
+
+    // the database is used only by the writer thread, which is woken up by changes of the counter.
+    // the active sampler, the focus sampler and the exit watcher have their own queues
+    record_queue               active_queue_;
+    record_queue               focus_queue_;
+    record_queue               exit_queue_;
+    std::atomic<std::uint64_t> pushed_ = 0;
+    std::atomic_bool           writing_;
+    std::atomic<std::size_t>   pending_ = 0;
+
+    poll_state active_poll_;
+    poll_state focus_poll_;
+
+    cycle_latency     active_latency_;
+    cycle_latency     focus_latency_;
+    latency_histogram journal_latency_;
+    latency_histogram write_latency_;
+
+    // reused by every cycle of the active sampler, so enumerating processes doesn't allocate memory.
+    // it's used only by the active sampler and isn't guarded by the mutex
+    process_buffer buffer_;
+
+    // the scope requested by the settings and the scope applied to the manager (used only by the active sampler)
+    process_scope scan_scope_;
+    process_scope applied_scope_;
+
+    // the rules requested by the settings and the tree that applies them (used only by the active sampler)
+    std::vector<std::string> tree_roots_;
+    process_tree             tree_;
+
+    // the focused interval, it's written when it opens, every checkpoint interval and when it closes (used only by the focus sampler).
+    // the sampler is woken up by focus changes if the manager reports them, otherwise it polls
+    record                                focus_last_;
+    bool                                  focus_dirty_  = false;
+    bool                                  focus_idle_   = false;
+    bool                                  focus_events_ = false;
+    std::chrono::steady_clock::time_point focus_checkpointed_;
+
+    // the idle state reported by the detector, the time the user left or came back.
+    // focus intervals don't start before the user came back
+    bool                                  idle_ = false;
+    std::chrono::system_clock::time_point idle_since_;
+    std::chrono::system_clock::time_point resumed_;
 
-    std::thread active_thread_;
-    std::thread focus_thread_;
+    // set when a written process exits, it's a change seen by the next cycle of the active sampler
+    bool exited_ = false;
 
-    std::shared_ptr<database>    db_;
-    std::unique_ptr<process_mgr> manager_;
+    // the open intervals of written processes by process ID and the number of the current cycle of the active sampler
+    std::unordered_map<int, active_session> sessions_;
+    std::uint64_t                           cycle_ = 0;
 
-    std::mutex              mutex_;
-    std::atomic_bool        running_;
-    std::condition_variable cv;
+    // processes whose exit is waited by the watcher
+    std::unordered_map<int, process_info> tracked_;
+    exit_watcher                          watcher_;
 };
 } // namespace apptime
 
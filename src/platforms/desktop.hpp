@@ -0,0 +1,32 @@
+#ifndef APPTIME_DESKTOP_HPP
+#define APPTIME_DESKTOP_HPP
+
+#include <string>
+#include <string_view>
+
+namespace apptime {
+/**
+ * @brief Start loading the applications known to the desktop environment in the background, it's called once at startup.
+ *
+ * The index is refreshed in the background too. Names and icons are empty until it's loaded.
+ */
+void load_desktop_entries();
+
+/**
+ * @brief Get the display name of an application known to the desktop environment, e.g. "Name" of its .desktop file on Linux.
+ *
+ * @param path The full path of the executable.
+ * @return std::string The display name, or an empty string if the application is unknown.
+ */
+std::string application_display_name(std::string_view path);
+
+/**
+ * @brief Get the icon of an application known to the desktop environment, e.g. "Icon" of its .desktop file on Linux.
+ *
+ * @param path The full path of the executable.
+ * @return std::string The icon name or an absolute path to the icon, or an empty string if the application is unknown.
+ */
+std::string application_icon_name(std::string_view path);
+} // namespace apptime
+
+#endif // APPTIME_DESKTOP_HPP
\ No newline at end of file
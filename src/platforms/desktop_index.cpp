@@ -0,0 +1,514 @@
+#include "desktop_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <unordered_set>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// launchers run another program, so their processes can't be told apart by the executable
+constexpr std::array<std::string_view, 12> desktop_launchers = {
+    "bash", "flatpak", "gjs", "java", "mono", "perl", "python", "python3", "sh", "snap", "wine", "xdg-open",
+};
+
+// get an environment variable, an unset one is empty
+std::string_view environment(const char *name) {
+    const char *value = std::getenv(name); // NOLINT(concurrency-mt-unsafe)
+    return value ? value : "";
+}
+
+// the modification time of a directory in nanoseconds, 0 if it doesn't exist
+std::int64_t directory_mtime(const fs::path &dir) {
+    struct stat dir_stat = {};
+    if (stat(dir.c_str(), &dir_stat) == -1) {
+        return 0;
+    }
+    return static_cast<std::int64_t>(dir_stat.st_mtim.tv_sec) * 1'000'000'000 + dir_stat.st_mtim.tv_nsec;
+}
+
+// unescape a string value of a desktop entry (\s, \n, \t, \r and \\), line breaks and tabs become spaces, so a value fits a field of the cache
+std::string desktop_unescape(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (std::size_t i = 0; i < value.size(); i++) {
+        if (value[i] != '\\' || i + 1 == value.size()) {
+            result += value[i] == '\t' ? ' ' : value[i];
+            continue;
+        }
+        switch (value[++i]) {
+        case 's':
+        case 'n':
+        case 't':
+        case 'r':
+            result += ' ';
+            break;
+        default:
+            result += value[i];
+            break;
+        }
+    }
+    return result;
+}
+
+// the first argument of a command line of Exec, quoted arguments can contain escaped quotes, backslashes and dollar signs
+std::string_view next_argument(std::string_view &command, std::string &storage) {
+    const std::size_t start = command.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        command = {};
+        return {};
+    }
+    command.remove_prefix(start);
+
+    if (command.front() != '"') {
+        const std::size_t      end    = command.find(' ');
+        const std::string_view result = command.substr(0, end);
+        command.remove_prefix(end == std::string_view::npos ? command.size() : end);
+        return result;
+    }
+
+    storage.clear();
+    std::size_t i = 1;
+    for (; i < command.size() && command[i] != '"'; i++) {
+        if (command[i] == '\\' && i + 1 < command.size()) {
+            i++;
+        }
+        storage += command[i];
+    }
+    command.remove_prefix(std::min(i + 1, command.size()));
+    return storage;
+}
+
+// the program of an Exec command line, a leading env with its assignments is skipped
+std::string exec_program(std::string_view command) {
+    std::string storage;
+    for (std::string_view argument = next_argument(command, storage); !argument.empty(); argument = next_argument(command, storage)) {
+        if (argument == "env" || argument.find('=') != std::string_view::npos) {
+            continue;
+        }
+        return std::string{argument};
+    }
+    return {};
+}
+
+// the full path of a program, a bare name is searched in PATH and symbolic links are resolved like readlink of /proc/<pid>/exe does
+std::string resolve_program(std::string_view program) {
+    std::error_code ec;
+    if (program.find('/') != std::string_view::npos) {
+        const fs::path result = fs::canonical(program, ec);
+        return ec ? std::string{program} : result.string();
+    }
+
+    std::string_view path = environment("PATH");
+    while (!path.empty()) {
+        const std::size_t      end = path.find(':');
+        const std::string_view dir = path.substr(0, end);
+        path.remove_prefix(end == std::string_view::npos ? path.size() : end + 1);
+        if (dir.empty()) {
+            continue;
+        }
+
+        const fs::path candidate = fs::path{dir} / program;
+        if (access(candidate.c_str(), X_OK) == 0) {
+            const fs::path result = fs::canonical(candidate, ec);
+            return ec ? candidate.string() : result.string();
+        }
+    }
+    return {};
+}
+
+// split a line of the cache by tabs
+std::vector<std::string_view> split_fields(std::string_view line) {
+    std::vector<std::string_view> result;
+    while (true) {
+        const std::size_t end = line.find('\t');
+        result.push_back(line.substr(0, end));
+        if (end == std::string_view::npos) {
+            return result;
+        }
+        line.remove_prefix(end + 1);
+    }
+}
+
+namespace apptime {
+bool parse_desktop_entry(std::istream &input, std::string_view locale, desktop_entry &entry) {
+    // a localized name is chosen by the most specific locale: lang_COUNTRY, lang, untranslated
+    const std::string_view language      = locale.substr(0, locale.find('_'));
+    int                    name_priority = -1;
+
+    bool        in_group    = false;
+    bool        application = false;
+    std::string exec, try_exec;
+    for (std::string line; std::getline(input, line);) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        if (line.front() == '[') {
+            // the main group is the first one, other groups are actions
+            if (in_group) {
+                break;
+            }
+            in_group = line == "[Desktop Entry]";
+            continue;
+        }
+        if (!in_group) {
+            continue;
+        }
+
+        const std::size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        std::string_view key{line.data(), separator};
+        std::string_view value{line.data() + separator + 1, line.size() - separator - 1};
+        while (!key.empty() && key.back() == ' ') {
+            key.remove_suffix(1);
+        }
+        while (!value.empty() && value.front() == ' ') {
+            value.remove_prefix(1);
+        }
+
+        if (key == "Type") {
+            application = value == "Application";
+        } else if (key == "Name" && name_priority < 0) {
+            entry.name    = desktop_unescape(value);
+            name_priority = 0;
+        } else if (key.starts_with("Name[") && key.ends_with(']') && !locale.empty()) {
+            const std::string_view name_locale = key.substr(5, key.size() - 6);
+            const int              priority    = name_locale == locale ? 2 : (name_locale == language ? 1 : -1);
+            if (priority > name_priority) {
+                entry.name    = desktop_unescape(value);
+                name_priority = priority;
+            }
+        } else if (key == "Icon") {
+            entry.icon = desktop_unescape(value);
+        } else if (key == "Exec") {
+            exec = desktop_unescape(value);
+        } else if (key == "TryExec") {
+            try_exec = desktop_unescape(value);
+        } else if (key == "Hidden") {
+            entry.hidden = value == "true";
+        }
+    }
+
+    for (std::string program: {exec_program(exec), try_exec}) {
+        if (!program.empty() && std::ranges::find(entry.programs, program) == entry.programs.end()) {
+            entry.programs.push_back(std::move(program));
+        }
+    }
+    return application;
+}
+
+desktop_index::desktop_index(std::vector<fs::path> dirs, fs::path cache, std::string locale)
+    : dirs_{std::move(dirs)},
+      cache_{std::move(cache)},
+      locale_{std::move(locale)} {
+    load();
+    watch();
+}
+
+desktop_index::~desktop_index() {
+    if (inotify_fd_ != -1) {
+        close(inotify_fd_);
+    }
+}
+
+std::vector<fs::path> xdg_data_dirs() {
+    // see the XDG Base Directory Specification
+    std::vector<fs::path> result;
+    if (const std::string_view data_home = environment("XDG_DATA_HOME"); !data_home.empty()) {
+        result.emplace_back(data_home);
+    } else if (const std::string_view home = environment("HOME"); !home.empty()) {
+        result.push_back(fs::path{home} / ".local/share");
+    }
+
+    std::string_view data_dirs = environment("XDG_DATA_DIRS");
+    if (data_dirs.empty()) {
+        data_dirs = "/usr/local/share:/usr/share";
+    }
+    while (!data_dirs.empty()) {
+        const std::size_t      end = data_dirs.find(':');
+        const std::string_view dir = data_dirs.substr(0, end);
+        data_dirs.remove_prefix(end == std::string_view::npos ? data_dirs.size() : end + 1);
+        if (!dir.empty()) {
+            result.emplace_back(dir);
+        }
+    }
+    return result;
+}
+
+std::vector<fs::path> desktop_index::default_dirs() {
+    std::vector<fs::path> result = xdg_data_dirs();
+    for (auto &dir: result) {
+        dir /= "applications";
+    }
+    return result;
+}
+
+fs::path desktop_index::default_cache() {
+    if (const std::string_view cache_home = environment("XDG_CACHE_HOME"); !cache_home.empty()) {
+        return fs::path{cache_home} / "apptime/desktop-index";
+    }
+    if (const std::string_view home = environment("HOME"); !home.empty()) {
+        return fs::path{home} / ".cache/apptime/desktop-index";
+    }
+    return {};
+}
+
+std::string desktop_index::default_locale() {
+    std::string_view result = environment("LC_ALL");
+    if (result.empty()) {
+        result = environment("LC_MESSAGES");
+    }
+    if (result.empty()) {
+        result = environment("LANG");
+    }
+
+    // lang_COUNTRY.ENCODING@MODIFIER, the modifier is dropped too
+    result = result.substr(0, result.find_first_of(".@"));
+    if (result == "C" || result == "POSIX") {
+        return {};
+    }
+    return std::string{result};
+}
+
+const desktop_entry *desktop_index::find(std::string_view executable) const {
+    auto it = programs_.find(std::string{executable});
+    if (it == programs_.end()) {
+        it = programs_.find(fs::path{executable}.filename().string());
+    }
+    return it != programs_.end() ? &entries_[it->second] : nullptr;
+}
+
+bool desktop_index::refresh() {
+    if (!changed()) {
+        return false;
+    }
+
+    build();
+    save_cache();
+    watch();
+    return true;
+}
+
+bool desktop_index::changed() {
+#ifdef __linux__
+    if (inotify_fd_ == -1) {
+        return false;
+    }
+
+    // drain the events, any of them means that an entry was added, removed or changed,
+    // except for events of a parent of a missing directory that don't create the directory
+    alignas(inotify_event) std::array<char, 4096> buffer = {};
+    bool                                          result = false;
+    ssize_t                                       length = 0;
+    while ((length = read(inotify_fd_, buffer.data(), buffer.size())) > 0) {
+        for (std::size_t offset = 0; offset < static_cast<std::size_t>(length);) {
+            const auto *event = std::bit_cast<const inotify_event *>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            const auto it = parents_.find(event->wd);
+            if (it == parents_.end() || (event->mask & IN_IGNORED) != 0 ||
+                (event->len > 0 && std::ranges::find(it->second, std::string_view{event->name}) != it->second.end())) {
+                result = true;
+            }
+        }
+    }
+    return result;
+#else
+    return false;
+#endif
+}
+
+void desktop_index::load() {
+    if (load_cache()) {
+        cached_ = true;
+        return;
+    }
+    build();
+    save_cache();
+}
+
+bool desktop_index::load_cache() {
+    std::ifstream fp{cache_};
+    std::string   line;
+    if (cache_.empty() || !std::getline(fp, line) || line != std::format("apptime-desktop-index\t{}\t{}", cache_version, locale_)) {
+        return false;
+    }
+
+    entries_.clear();
+    programs_.clear();
+    scanned_.clear();
+    std::vector<fs::path> roots;
+    while (std::getline(fp, line)) {
+        const std::vector<std::string_view> fields = split_fields(line);
+        if (fields[0] == "r" && fields.size() == 2) {
+            roots.emplace_back(fields[1]);
+        } else if (fields[0] == "d" && fields.size() == 3) {
+            // a directory changed since the cache was written
+            std::int64_t mtime = 0;
+            std::from_chars(fields[1].data(), fields[1].data() + fields[1].size(), mtime);
+            if (directory_mtime(fields[2]) != mtime) {
+                return false;
+            }
+            scanned_.emplace_back(fields[2], mtime);
+        } else if (fields[0] == "e" && fields.size() >= 4) {
+            desktop_entry &entry = entries_.emplace_back();
+            entry.id.assign(fields[1]);
+            entry.name.assign(fields[2]);
+            entry.icon.assign(fields[3]);
+            entry.programs.assign(fields.begin() + 4, fields.end());
+        } else if (fields[0] == "p" && fields.size() == 3) {
+            std::size_t index = 0;
+            std::from_chars(fields[2].data(), fields[2].data() + fields[2].size(), index);
+            if (index < entries_.size()) {
+                programs_.emplace(fields[1], index);
+            }
+        }
+    }
+
+    // the data directories must be the same, e.g. XDG_DATA_DIRS can change between sessions
+    return roots == dirs_;
+}
+
+void desktop_index::save_cache() const {
+    if (cache_.empty()) {
+        return;
+    }
+    std::error_code ec;
+    fs::create_directories(cache_.parent_path(), ec);
+
+    // the cache is replaced at once, so another instance never reads a partial file
+    const fs::path temporary = cache_.string() + ".tmp";
+    {
+        std::ofstream fp{temporary, std::ios::trunc};
+        fp << std::format("apptime-desktop-index\t{}\t{}\n", cache_version, locale_);
+        for (const auto &dir: dirs_) {
+            fp << std::format("r\t{}\n", dir.string());
+        }
+        for (const auto &[dir, mtime]: scanned_) {
+            fp << std::format("d\t{}\t{}\n", mtime, dir.string());
+        }
+        for (const auto &entry: entries_) {
+            fp << std::format("e\t{}\t{}\t{}", entry.id, entry.name, entry.icon);
+            for (const auto &program: entry.programs) {
+                fp << '\t' << program;
+            }
+            fp << '\n';
+        }
+        for (const auto &[program, index]: programs_) {
+            fp << std::format("p\t{}\t{}\n", program, index);
+        }
+        if (!fp) {
+            fs::remove(temporary, ec);
+            return;
+        }
+    }
+    fs::rename(temporary, cache_, ec);
+}
+
+void desktop_index::build() {
+    entries_.clear();
+    programs_.clear();
+    scanned_.clear();
+    cached_ = false;
+
+    // an entry of a directory with higher priority hides the entries with the same ID in the next directories
+    std::unordered_set<std::string> ids;
+    for (const auto &dir: dirs_) {
+        scanned_.emplace_back(dir, directory_mtime(dir));
+
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it{dir, ec}, end; !ec && it != end; it.increment(ec)) {
+            if (it->is_directory(ec)) {
+                scanned_.emplace_back(it->path(), directory_mtime(it->path()));
+                continue;
+            }
+            if (it->path().extension() != ".desktop") {
+                continue;
+            }
+
+            // the ID of a file in a subdirectory is its relative path with '-' instead of '/'
+            std::string id = it->path().lexically_relative(dir).string();
+            std::ranges::replace(id, '/', '-');
+            if (!ids.insert(id).second) {
+                continue;
+            }
+
+            std::ifstream fp{it->path()};
+            desktop_entry entry;
+            entry.id = std::move(id);
+            if (parse_desktop_entry(fp, locale_, entry) && !entry.hidden && !entry.name.empty()) {
+                add(std::move(entry));
+            }
+        }
+    }
+}
+
+void desktop_index::add(desktop_entry entry) {
+    const std::size_t index = entries_.size();
+    for (const auto &program: entry.programs) {
+        const std::string name = fs::path{program}.filename().string();
+        if (std::ranges::find(desktop_launchers, name) != desktop_launchers.end()) {
+            continue;
+        }
+        if (const std::string path = resolve_program(program); !path.empty()) {
+            programs_.try_emplace(path, index);
+        }
+        programs_.try_emplace(name, index);
+    }
+    entries_.push_back(std::move(entry));
+}
+
+void desktop_index::watch() {
+#ifdef __linux__
+    // the watches are set up again, so directories created since the last build are watched too
+    if (inotify_fd_ != -1) {
+        close(inotify_fd_);
+    }
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ == -1) {
+        return;
+    }
+
+    constexpr std::uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF;
+    std::unordered_set<int> watched;
+    parents_.clear();
+    for (const auto &[dir, mtime]: scanned_) {
+        if (mtime != 0) {
+            watched.insert(inotify_add_watch(inotify_fd_, dir.c_str(), mask));
+            continue;
+        }
+
+        // a missing directory, e.g. ~/.local/share/applications before the first application of the user is installed
+        fs::path child  = dir;
+        fs::path parent = dir.parent_path();
+        while (directory_mtime(parent) == 0 && parent.has_relative_path()) {
+            child  = parent;
+            parent = parent.parent_path();
+        }
+        if (const int wd = inotify_add_watch(inotify_fd_, parent.c_str(), IN_CREATE | IN_MOVED_TO | IN_MASK_ADD); wd != -1) {
+            parents_[wd].push_back(child.filename().string());
+        }
+    }
+
+    // a parent that is scanned itself reports all of its events
+    for (const int wd: watched) {
+        parents_.erase(wd);
+    }
+#endif
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,182 @@
+#ifndef APPTIME_DESKTOP_INDEX_HPP
+#define APPTIME_DESKTOP_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace apptime {
+/// @brief An application of a .desktop file.
+struct desktop_entry {
+    /// @brief The desktop file ID, e.g. "org.mozilla.firefox.desktop".
+    std::string id;
+    /// @brief The display name, localized if the file has a translation.
+    std::string name;
+    /// @brief The icon name or an absolute path to the icon (empty if none).
+    std::string icon;
+    /// @brief The programs of `Exec` and `TryExec` as they are written in the file.
+    std::vector<std::string> programs;
+    /// @brief The entry is deleted by the user, it hides entries with the same ID in data directories of lower priority.
+    bool hidden = false;
+};
+
+/**
+ * @brief Get the XDG data directories, `XDG_DATA_HOME` followed by `XDG_DATA_DIRS` (with the defaults of the XDG Base Directory Specification).
+ *
+ * @return std::vector<std::filesystem::path> The directories in the order of priority.
+ */
+std::vector<std::filesystem::path> xdg_data_dirs();
+
+/**
+ * @brief Parse the "Desktop Entry" group of a .desktop file.
+ *
+ * Only applications are parsed. The name is taken from `Name[locale]` with fallbacks to `Name[lang]` and `Name`.
+ * The program of `Exec` is its first argument, environment assignments of a leading `env` are skipped.
+ *
+ * @param input The content of the file.
+ * @param locale The locale of the name, e.g. "de_DE" (empty for the untranslated name).
+ * @param entry The parsed entry, the ID isn't set.
+ * @return true if the file describes an application, false otherwise.
+ */
+bool parse_desktop_entry(std::istream &input, std::string_view locale, desktop_entry &entry);
+
+/**
+ * @brief The class maps executables to applications of .desktop files in the XDG data directories.
+ *
+ * The files are parsed once and the index is saved to a cache file. The cache is used as long as the modification times
+ * of the data directories haven't changed, so a usual start doesn't parse any file. On Linux, the directories are watched by inotify
+ * and `refresh` rebuilds the index when they change.
+ * An executable is found by its full path (`Exec` resolved by `PATH` and symbolic links), or by its file name.
+ */
+class desktop_index {
+public:
+    /// @brief The version of the cache file format.
+    static constexpr int cache_version = 1;
+
+    /**
+     * @brief Construct a new index, it's loaded from the cache or built from the directories.
+     *
+     * @param dirs The directories with .desktop files in the order of priority.
+     * @param cache The cache file (empty to not use a cache).
+     * @param locale The locale of names, e.g. "de_DE" (empty for untranslated names).
+     */
+    explicit desktop_index(std::vector<std::filesystem::path> dirs = default_dirs(), std::filesystem::path cache = default_cache(),
+                           std::string locale = default_locale());
+    ~desktop_index();
+
+    desktop_index(const desktop_index &)            = delete;
+    desktop_index &operator=(const desktop_index &) = delete;
+
+    /**
+     * @brief Get the "applications" directories of `XDG_DATA_HOME` and `XDG_DATA_DIRS`.
+     *
+     * @return std::vector<std::filesystem::path> The directories in the order of priority.
+     */
+    static std::vector<std::filesystem::path> default_dirs();
+
+    /**
+     * @brief Get the cache file in `XDG_CACHE_HOME`.
+     *
+     * @return std::filesystem::path The cache file.
+     */
+    static std::filesystem::path default_cache();
+
+    /**
+     * @brief Get the locale of messages from `LC_ALL`, `LC_MESSAGES` or `LANG` without the encoding, e.g. "de_DE".
+     *
+     * @return std::string The locale, or an empty string for the "C" locale.
+     */
+    static std::string default_locale();
+
+    /**
+     * @brief Find the application of an executable.
+     *
+     * @param executable The full path of the executable.
+     * @return const desktop_entry* The application, or nullptr if it's unknown.
+     */
+    const desktop_entry *find(std::string_view executable) const;
+
+    /**
+     * @brief Rebuild the index if the directories have changed since the last call, it doesn't block.
+     *
+     * @return true if the index is rebuilt, false otherwise.
+     */
+    bool refresh();
+
+    /**
+     * @brief Check if the directories have changed since the last call without rebuilding the index, it doesn't block.
+     *
+     * The index isn't touched, so another thread can find applications meanwhile.
+     *
+     * @return true if the directories have changed, false otherwise.
+     */
+    bool changed();
+
+    /**
+     * @brief Get the inotify descriptor, it becomes readable when the directories change, so `changed` can be waited for by poll.
+     *
+     * @return int The descriptor, or -1 if the directories aren't watched. It's replaced by `refresh`.
+     */
+    int inotify_fd() const { return inotify_fd_; }
+
+    /**
+     * @brief Check if the index was loaded from the cache, so no file was parsed.
+     *
+     * @return true if the index is loaded from the cache, false otherwise.
+     */
+    bool cached() const { return cached_; }
+
+    std::size_t size() const { return entries_.size(); }
+
+private:
+    /// @brief Load the index from the cache, or build it and save the cache.
+    void load();
+
+    /**
+     * @brief Load the index from the cache file.
+     *
+     * @return true if the cache is valid, false otherwise.
+     */
+    bool load_cache();
+
+    /// @brief Save the index to the cache file.
+    void save_cache() const;
+
+    /// @brief Parse the .desktop files of the directories.
+    void build();
+
+    /**
+     * @brief Add an application and map its programs to it, programs of applications added before aren't remapped.
+     *
+     * @param entry The application.
+     */
+    void add(desktop_entry entry);
+
+    /// @brief Watch the scanned directories, a missing directory is watched through its nearest existing parent until it's created.
+    void watch();
+
+    std::vector<std::filesystem::path> dirs_;
+    std::filesystem::path              cache_;
+    std::string                        locale_;
+
+    std::vector<desktop_entry> entries_;
+    /// @brief Indexes of applications by full paths and file names of their programs.
+    std::unordered_map<std::string, std::size_t> programs_;
+    /// @brief The scanned directories and their modification times in nanoseconds (0 if a directory doesn't exist), they validate the cache.
+    std::vector<std::pair<std::filesystem::path, std::int64_t>> scanned_;
+    bool                                                        cached_ = false;
+
+    /// @brief The inotify descriptor (-1 if the directories aren't watched).
+    int inotify_fd_ = -1;
+    /// @brief The watches of parents of missing directories and the names of their children that lead to the missing directories.
+    std::unordered_map<int, std::vector<std::string>> parents_;
+};
+} // namespace apptime
+
+#endif // APPTIME_DESKTOP_INDEX_HPP
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "desktop.hpp"
+
+#include <array>
+#include <cerrno>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "desktop_index.hpp"
+
+// the index of desktop entries, it's built and refreshed by a background thread, so lookups of the GUI thread and the icon loader don't parse files
+class desktop_entries {
+public:
+    // a burst of changes (e.g. a package installing several entries) is waited for this long, so the index is rebuilt once
+    static constexpr int settle_ms = 500;
+
+    desktop_entries() : wakeup_{eventfd(0, EFD_CLOEXEC)}, thread_{&desktop_entries::load_thread, this} {}
+
+    ~desktop_entries() {
+        if (wakeup_ != -1) {
+            eventfd_write(wakeup_, 1);
+        }
+        thread_.join();
+        if (wakeup_ != -1) {
+            close(wakeup_);
+        }
+    }
+
+    desktop_entries(const desktop_entries &)            = delete;
+    desktop_entries &operator=(const desktop_entries &) = delete;
+
+    // get a field of the desktop entry of an executable (empty until the index is loaded)
+    std::string field(std::string_view path, std::string apptime::desktop_entry::*field) const {
+        std::shared_ptr<const apptime::desktop_index> index;
+        {
+            const std::lock_guard<std::mutex> lock{mutex_};
+            index = index_;
+        }
+        const apptime::desktop_entry *entry = index ? index->find(path) : nullptr;
+        return entry ? entry->*field : std::string{};
+    }
+
+private:
+    void load_thread() {
+        auto index = std::make_shared<apptime::desktop_index>();
+        publish(index);
+        if (wakeup_ == -1) {
+            return;
+        }
+
+        // the thread sleeps until the directories change or the application quits, a pending wakeup is kept by the eventfd
+        while (true) {
+            std::array<pollfd, 2> fds = {{
+                {.fd = index->inotify_fd(), .events = POLLIN, .revents = 0},
+                {.fd = wakeup_, .events = POLLIN, .revents = 0},
+            }};
+            if (poll(fds.data(), fds.size(), -1) == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            if (fds[1].revents) {
+                return;
+            }
+            if (poll(&fds[1], 1, settle_ms) > 0) {
+                return;
+            }
+
+            // readers may hold the published index, so a changed one is replaced by a new index instead of being rebuilt in place
+            if (index->changed()) {
+                index = std::make_shared<apptime::desktop_index>();
+                publish(index);
+            }
+        }
+    }
+
+    void publish(std::shared_ptr<const apptime::desktop_index> index) {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        index_ = std::move(index);
+    }
+
+    // the eventfd used to wake up the thread when the application quits
+    int wakeup_;
+
+    mutable std::mutex                            mutex_;
+    std::shared_ptr<const apptime::desktop_index> index_;
+    std::thread                                   thread_;
+};
+
+desktop_entries &shared_desktop_entries() {
+    static desktop_entries entries;
+    return entries;
+}
+
+namespace apptime {
+void load_desktop_entries() {
+    shared_desktop_entries();
+}
+
+std::string application_display_name(std::string_view path) {
+    return shared_desktop_entries().field(path, &desktop_entry::name);
+}
+
+std::string application_icon_name(std::string_view path) {
+    return shared_desktop_entries().field(path, &desktop_entry::icon);
+}
+} // namespace apptime
\ No newline at end of file
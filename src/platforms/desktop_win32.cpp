@@ -0,0 +1,13 @@
+#include "desktop.hpp"
+
+namespace apptime {
+void load_desktop_entries() {}
+
+std::string application_display_name(std::string_view /*path*/) {
+    return {};
+}
+
+std::string application_icon_name(std::string_view /*path*/) {
+    return {};
+}
+} // namespace apptime
\ No newline at end of file
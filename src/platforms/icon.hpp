@@ -1,12 +1,21 @@
 #ifndef APPTIME_ICON_HPP
 #define APPTIME_ICON_HPP
 
-#include <QIcon>
+#include <QImage>
+#include <QString>
 
 #include <string_view>
 
 namespace apptime {
-QIcon application_icon(std::string_view path);
+/**
+ * @brief Load the icon of an application, it can be called by any thread.
+ *
+ * @param path The full path of the executable.
+ * @param size The size in pixels, the image fits into a square of this size.
+ * @param theme The icon theme of the desktop (used on Linux).
+ * @return QImage The icon, or a null image if the application has no icon.
+ */
+QImage application_image(std::string_view path, int size, const QString &theme);
 } // namespace apptime
 
 #endif // APPTIME_ICON_HPP
\ No newline at end of file
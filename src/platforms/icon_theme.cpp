@@ -0,0 +1,224 @@
+#include "icon_theme.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+
+#include "desktop_index.hpp"
+
+namespace fs = std::filesystem;
+
+// the formats of icons in the order of preference
+constexpr std::array<std::string_view, 3> icon_extensions = {".png", ".svg", ".xpm"};
+
+// the rank of an icon file by its extension, or -1 if it isn't an icon
+int icon_extension_rank(const fs::path &file) {
+    const auto it = std::ranges::find(icon_extensions, file.extension().string());
+    return it != icon_extensions.end() ? static_cast<int>(it - icon_extensions.begin()) : -1;
+}
+
+// parse an integer value of index.theme, an invalid value keeps the default
+void parse_theme_int(std::string_view value, int &result) {
+    int parsed = 0;
+    if (std::from_chars(value.data(), value.data() + value.size(), parsed).ec == std::errc{}) {
+        result = parsed;
+    }
+}
+
+// split a list value of index.theme by commas
+std::vector<std::string> split_theme_list(std::string_view value) {
+    std::vector<std::string> result;
+    while (!value.empty()) {
+        const std::size_t end = value.find(',');
+        if (const std::string_view item = value.substr(0, end); !item.empty()) {
+            result.emplace_back(item);
+        }
+        value.remove_prefix(end == std::string_view::npos ? value.size() : end + 1);
+    }
+    return result;
+}
+
+namespace apptime {
+int icon_theme::directory::distance(int wanted) const {
+    switch (type) {
+    case kind::fixed:
+        return std::abs(size - wanted);
+    case kind::scalable:
+        return wanted < min_size ? min_size - wanted : std::max(wanted - max_size, 0);
+    case kind::threshold:
+    default:
+        return wanted < size - threshold ? size - threshold - wanted : std::max(wanted - size - threshold, 0);
+    }
+}
+
+icon_theme::icon_theme(std::string theme, std::vector<fs::path> base_dirs) : base_dirs_{std::move(base_dirs)} {
+    load(theme.empty() ? "hicolor" : theme);
+    load("hicolor");
+
+    for (const auto &base: base_dirs_) {
+        std::error_code ec;
+        for (fs::directory_iterator it{base, ec}, end; !ec && it != end; it.increment(ec)) {
+            if (icon_extension_rank(it->path()) != -1) {
+                unthemed_.try_emplace(it->path().stem().string(), it->path());
+            }
+        }
+    }
+}
+
+std::vector<fs::path> icon_theme::default_dirs() {
+    // see the Icon Theme Specification
+    std::vector<fs::path> result;
+    if (const char *home = std::getenv("HOME")) { // NOLINT(concurrency-mt-unsafe)
+        result.push_back(fs::path{home} / ".icons");
+    }
+    for (const auto &dir: xdg_data_dirs()) {
+        result.push_back(dir / "icons");
+    }
+    result.emplace_back("/usr/share/pixmaps");
+    return result;
+}
+
+fs::path icon_theme::find(std::string_view icon, int size) const {
+    if (icon.empty()) {
+        return {};
+    }
+    if (icon.front() == '/') {
+        std::error_code ec;
+        return fs::is_regular_file(icon, ec) ? fs::path{icon} : fs::path{};
+    }
+
+    // some entries have the extension in the icon name
+    std::string name{icon};
+    if (icon_extension_rank(name) != -1) {
+        name = fs::path{name}.stem().string();
+    }
+
+    for (const auto &theme: themes_) {
+        const auto it = theme.icons.find(name);
+        if (it == theme.icons.end()) {
+            continue;
+        }
+
+        // the closest size, a better format for the same size
+        const icon_file *best          = nullptr;
+        auto             best_distance = std::pair{std::numeric_limits<int>::max(), 0};
+        for (const auto &file: it->second) {
+            const auto distance = std::pair{theme.directories[file.directory].distance(size), icon_extension_rank(file.path)};
+            if (distance < best_distance) {
+                best          = &file;
+                best_distance = distance;
+            }
+        }
+        return best->path;
+    }
+
+    const auto it = unthemed_.find(name);
+    return it != unthemed_.end() ? it->second : fs::path{};
+}
+
+std::vector<std::string> icon_theme::themes() const {
+    std::vector<std::string> result;
+    for (const auto &theme: themes_) {
+        result.push_back(theme.name);
+    }
+    return result;
+}
+
+void icon_theme::load(const std::string &name) {
+    if (std::ranges::find(themes_, name, &theme_index::name) != themes_.end()) {
+        return;
+    }
+
+    // index.theme is read from the first base directory that has it, icons are collected from all of them
+    std::ifstream fp;
+    for (const auto &base: base_dirs_) {
+        fp.open(base / name / "index.theme");
+        if (fp) {
+            break;
+        }
+        fp.clear();
+    }
+    if (!fp.is_open()) {
+        return;
+    }
+
+    theme_index theme;
+    theme.name = name;
+
+    std::vector<std::string> inherits, directory_names;
+    std::string              section;
+    directory               *current = nullptr;
+    for (std::string line; std::getline(fp, line);) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        if (line.front() == '[' && line.back() == ']') {
+            section = line.substr(1, line.size() - 2);
+
+            // only the directories listed by the theme are used, the sections can be in any order
+            current = nullptr;
+            if (const auto it = std::ranges::find(directory_names, section); it != directory_names.end()) {
+                current = &theme.directories[static_cast<std::size_t>(it - directory_names.begin())];
+            }
+            continue;
+        }
+
+        const std::size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        const std::string_view key{line.data(), separator};
+        const std::string_view value{line.data() + separator + 1, line.size() - separator - 1};
+
+        if (section == "Icon Theme") {
+            if (key == "Inherits") {
+                inherits = split_theme_list(value);
+            } else if (key == "Directories") {
+                directory_names = split_theme_list(value);
+                theme.directories.assign(directory_names.size(), {});
+            }
+        } else if (current) {
+            if (key == "Size") {
+                parse_theme_int(value, current->size);
+            } else if (key == "MinSize") {
+                parse_theme_int(value, current->min_size);
+            } else if (key == "MaxSize") {
+                parse_theme_int(value, current->max_size);
+            } else if (key == "Threshold") {
+                parse_theme_int(value, current->threshold);
+            } else if (key == "Type") {
+                current->type = value == "Fixed" ? directory::kind::fixed : (value == "Scalable" ? directory::kind::scalable : directory::kind::threshold);
+            }
+        }
+    }
+
+    // the minimum and maximum sizes of scalable directories default to the size
+    for (auto &dir: theme.directories) {
+        dir.min_size = dir.min_size ? dir.min_size : dir.size;
+        dir.max_size = dir.max_size ? dir.max_size : dir.size;
+    }
+
+    // list every directory once, so lookups don't check files
+    for (std::size_t i = 0; i < directory_names.size(); i++) {
+        for (const auto &base: base_dirs_) {
+            std::error_code ec;
+            for (fs::directory_iterator it{base / name / directory_names[i], ec}, end; !ec && it != end; it.increment(ec)) {
+                if (icon_extension_rank(it->path()) != -1) {
+                    theme.icons[it->path().stem().string()].push_back({.directory = i, .path = it->path()});
+                }
+            }
+        }
+    }
+
+    themes_.push_back(std::move(theme));
+    for (const auto &parent: inherits) {
+        load(parent);
+    }
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef APPTIME_ICON_THEME_HPP
+#define APPTIME_ICON_THEME_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace apptime {
+/**
+ * @brief The class finds icon files by name as described by the freedesktop Icon Theme Specification.
+ *
+ * The theme, the themes it inherits and "hicolor" are indexed once: `index.theme` of every theme is parsed
+ * and the directories of every theme are listed, so a lookup doesn't touch the file system.
+ * Icons that aren't in any theme are looked up in the base directories themselves (e.g. /usr/share/pixmaps).
+ */
+class icon_theme {
+public:
+    /**
+     * @brief Construct a new index of a theme.
+     *
+     * @param theme The theme name, e.g. "breeze" ("hicolor" if empty).
+     * @param base_dirs The base directories of themes in the order of priority.
+     */
+    explicit icon_theme(std::string theme, std::vector<std::filesystem::path> base_dirs = default_dirs());
+
+    /**
+     * @brief Get the base directories: `$HOME/.icons`, "icons" of the XDG data directories and /usr/share/pixmaps.
+     *
+     * @return std::vector<std::filesystem::path> The base directories in the order of priority.
+     */
+    static std::vector<std::filesystem::path> default_dirs();
+
+    /**
+     * @brief Find the file of an icon.
+     *
+     * The first theme of the inheritance chain that has the icon is used, its directory with the closest size is chosen.
+     *
+     * @param icon The icon name (e.g. "firefox") or an absolute path.
+     * @param size The wanted size in pixels.
+     * @return std::filesystem::path The file, or an empty path if the icon isn't found.
+     */
+    std::filesystem::path find(std::string_view icon, int size) const;
+
+    /**
+     * @brief Get the theme and the themes it inherits in the lookup order.
+     *
+     * @return std::vector<std::string> The names of the themes.
+     */
+    std::vector<std::string> themes() const;
+
+private:
+    /// @brief A directory of a theme (a section of `index.theme`).
+    struct directory {
+        enum class kind { fixed, scalable, threshold };
+
+        kind type      = kind::threshold;
+        int  size      = 0;
+        int  min_size  = 0;
+        int  max_size  = 0;
+        int  threshold = 2;
+
+        /**
+         * @brief Get the distance between the size of the directory and the wanted one.
+         *
+         * @param wanted The wanted size in pixels.
+         * @return int 0 if the directory matches the size.
+         */
+        int distance(int wanted) const;
+    };
+
+    /// @brief An icon file in a directory of a theme.
+    struct icon_file {
+        std::size_t           directory = 0;
+        std::filesystem::path path;
+    };
+
+    /// @brief An indexed theme.
+    struct theme_index {
+        std::string                                             name;
+        std::vector<directory>                                  directories;
+        std::unordered_map<std::string, std::vector<icon_file>> icons;
+    };
+
+    /**
+     * @brief Index a theme and the themes it inherits, themes that are indexed already are skipped.
+     *
+     * @param name The theme name.
+     */
+    void load(const std::string &name);
+
+    std::vector<std::filesystem::path> base_dirs_;
+    std::vector<theme_index>           themes_;
+    /// @brief Icons directly in the base directories.
+    std::unordered_map<std::string, std::filesystem::path> unthemed_;
+};
+} // namespace apptime
+
+#endif // APPTIME_ICON_THEME_HPP
\ No newline at end of file
@@ -1,7 +1,43 @@
 #include "icon.hpp"
 
+#include <memory>
+#include <mutex>
+
+#include <QImageReader>
+
+#include "desktop.hpp"
+#include "icon_theme.hpp"
+
+// find the icon file in the theme, the index is built once and rebuilt when the theme changes
+std::filesystem::path find_theme_icon(const std::string &icon, int size, const QString &theme) {
+    static std::mutex                           mutex;
+    static std::unique_ptr<apptime::icon_theme> index;
+    static QString                              index_theme;
+
+    const std::lock_guard<std::mutex> lock{mutex};
+    if (!index || index_theme != theme) {
+        index       = std::make_unique<apptime::icon_theme>(theme.toStdString());
+        index_theme = theme;
+    }
+    return index->find(icon, size);
+}
+
 namespace apptime {
-QIcon application_icon(std::string_view /*path*/) {
-    return {};
+QImage application_image(std::string_view path, int size, const QString &theme) {
+    const std::string icon = application_icon_name(path);
+    if (icon.empty()) {
+        return {};
+    }
+    const std::filesystem::path file = find_theme_icon(icon, size, theme);
+    if (file.empty()) {
+        return {};
+    }
+
+    // scalable icons are rendered at the size, others are scaled by the reader
+    QImageReader reader{QString::fromStdString(file.string())};
+    if (const QSize original = reader.size(); original.isValid() && original != QSize{size, size}) {
+        reader.setScaledSize(original.scaled(size, size, Qt::KeepAspectRatio));
+    }
+    return reader.read();
 }
 } // namespace apptime
\ No newline at end of file
@@ -4,7 +4,7 @@
 #include <Windows.h>
 
 namespace apptime {
-QIcon application_icon(std::string_view path) {
+QImage application_image(std::string_view path, int size, const QString & /*theme*/) {
     if (path.empty()) {
         return {};
     }
@@ -14,8 +14,11 @@ QIcon application_icon(std::string_view path) {
         return {};
     }
 
-    const QPixmap pixmap = QPixmap::fromImage(QImage::fromHICON(icon));
+    QImage image = QImage::fromHICON(icon);
     DestroyIcon(icon);
-    return pixmap;
+    if (!image.isNull() && image.size() != QSize{size, size}) {
+        image = image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return image;
 }
 } // namespace apptime
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "exe_cache.hpp"
+
+#include <functional>
+
+namespace apptime {
+std::size_t exe_cache::identity_hash::operator()(const exe_identity &exe) const {
+    // the inode alone is almost unique, the other fields only tell apart file systems and replaced files
+    std::size_t result = std::hash<std::uint64_t>{}(exe.inode);
+    result ^= std::hash<std::uint64_t>{}(exe.device) + 0x9e3779b97f4a7c15 + (result << 6) + (result >> 2);
+    result ^= std::hash<std::int64_t>{}(exe.mtime) + 0x9e3779b97f4a7c15 + (result << 6) + (result >> 2);
+    return result;
+}
+
+const exe_cache::entry *exe_cache::find(const exe_identity &exe) const {
+    const auto it = by_identity_.find(exe);
+    return it != by_identity_.end() ? &it->second : nullptr;
+}
+
+const exe_cache::entry &exe_cache::insert(const exe_identity &exe, std::string_view path) {
+    if (const entry *known = find(exe)) {
+        return *known;
+    }
+
+    // a new identity with a known path is the same application after an upgrade
+    const auto [it, added] = by_path_.try_emplace(std::string{path}, static_cast<std::uint32_t>(paths_.size() + 1));
+    if (added) {
+        paths_.emplace_back(path);
+    }
+    const std::uint32_t id = it->second;
+    return by_identity_.emplace(exe, entry{.id = id, .path = paths_[id - 1]}).first->second;
+}
+} // namespace apptime
\ No newline at end of file
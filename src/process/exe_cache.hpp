@@ -0,0 +1,70 @@
+#ifndef APPTIME_EXE_CACHE_HPP
+#define APPTIME_EXE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "process_buffer.hpp"
+
+namespace apptime {
+/**
+ * @brief The class maps identities of executables to small IDs and canonical paths.
+ *
+ * A renamed executable keeps its identity, so it keeps the ID and the path it was first seen with.
+ * A replaced executable (e.g. upgraded by a package manager) gets a new identity, but its path maps it to the ID it had before.
+ * So all processes of an application share an ID, and it's compared instead of paths.
+ *
+ * @warning `find` can be called by several threads at once, but not concurrently with `insert`.
+ */
+class exe_cache {
+public:
+    /// @brief A known executable.
+    struct entry {
+        /// @brief The ID of the executable (never 0).
+        std::uint32_t id = 0;
+        /// @brief The canonical path of the executable.
+        std::string path;
+    };
+
+    /**
+     * @brief Find a known executable.
+     *
+     * @param exe The identity of the executable.
+     * @return const entry* The executable, or nullptr if it's unknown.
+     */
+    const entry *find(const exe_identity &exe) const;
+
+    /**
+     * @brief Add an executable unless it's known.
+     *
+     * @param exe The identity of the executable.
+     * @param path The path of the executable, it's the canonical one unless the path has an ID already.
+     * @return const entry& The executable.
+     */
+    const entry &insert(const exe_identity &exe, std::string_view path);
+
+    /**
+     * @brief Get the number of known identities.
+     *
+     * @return std::size_t The number of identities.
+     */
+    std::size_t size() const { return by_identity_.size(); }
+
+private:
+    struct identity_hash {
+        std::size_t operator()(const exe_identity &exe) const;
+    };
+
+    std::unordered_map<exe_identity, entry, identity_hash> by_identity_;
+    /// @brief IDs by every path an executable was seen with.
+    std::unordered_map<std::string, std::uint32_t> by_path_;
+    /// @brief Canonical paths by ID - 1.
+    std::vector<std::string> paths_;
+};
+} // namespace apptime
+
+#endif // APPTIME_EXE_CACHE_HPP
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef APPTIME_EXIT_WATCHER_HPP
+#define APPTIME_EXIT_WATCHER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace apptime {
+/**
+ * @brief The class reports the exit of watched processes as soon as it happens.
+ *
+ * For Linux, every watched process is held by a pidfd and all of them are waited on by one epoll loop.
+ * For Windows, exits aren't reported and `watch` always returns false,
+ * so the sampler closes the interval of an exited process at its next cycle instead of at the time of the exit.
+ */
+class exit_watcher {
+public:
+    using time_point    = std::chrono::system_clock::time_point;
+    using callback_type = std::function<void(int pid, time_point exit_time)>;
+
+    /**
+     * @brief Construct a new watcher.
+     *
+     * @param callback The function called from the watcher thread when a watched process exits.
+     */
+    explicit exit_watcher(callback_type callback);
+    ~exit_watcher();
+
+    exit_watcher(const exit_watcher &)            = delete;
+    exit_watcher &operator=(const exit_watcher &) = delete;
+
+    /**
+     * @brief Start watching a process. Watching the same process again has no effect.
+     *
+     * @param pid The process ID.
+     * @return true if the process is watched, false if it doesn't exist or watching isn't supported.
+     */
+    bool watch(int pid);
+
+    /**
+     * @brief Stop watching a process without calling the callback.
+     *
+     * @param pid The process ID.
+     */
+    void unwatch(int pid);
+
+    /// @brief Stop watching all processes without calling the callback.
+    void clear();
+
+    /**
+     * @brief Check if a process is watched.
+     *
+     * @param pid The process ID.
+     * @return true if the process is watched, false otherwise.
+     */
+    bool watching(int pid) const;
+
+private:
+    /// @brief Wait for watched processes to exit until the watcher is destroyed.
+    void wait_thread();
+
+    callback_type callback_;
+
+    /// @brief Watched processes and their descriptors.
+    std::unordered_map<int, int> watched_;
+    mutable std::mutex           mutex_;
+
+#ifndef _WIN32
+    /// @brief The epoll descriptor.
+    int epoll_ = -1;
+    /// @brief The eventfd used to wake up the watcher thread.
+    int wakeup_ = -1;
+
+    std::thread      thread_;
+    std::atomic_bool running_;
+#endif
+};
+} // namespace apptime
+
+#endif // APPTIME_EXIT_WATCHER_HPP
\ No newline at end of file
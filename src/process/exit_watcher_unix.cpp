@@ -0,0 +1,150 @@
+#include "exit_watcher.hpp"
+
+#include <array>
+#include <cerrno>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// glibc < 2.36 has no pidfd_open wrapper
+int open_pidfd(int pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+namespace apptime {
+exit_watcher::exit_watcher(callback_type callback)
+    : callback_{std::move(callback)},
+      epoll_{epoll_create1(EPOLL_CLOEXEC)},
+      wakeup_{eventfd(0, EFD_CLOEXEC)},
+      running_{false} {
+    if (epoll_ == -1 || wakeup_ == -1) {
+        return;
+    }
+
+    epoll_event event = {};
+    event.events      = EPOLLIN;
+    event.data.fd     = -1; // the process IDs are stored in data, the wakeup is marked with -1
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, wakeup_, &event) == -1) {
+        return;
+    }
+
+    running_ = true;
+    thread_  = std::thread{&exit_watcher::wait_thread, this};
+}
+
+exit_watcher::~exit_watcher() {
+    running_ = false;
+    if (wakeup_ != -1) {
+        eventfd_write(wakeup_, 1);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    clear();
+    if (epoll_ != -1) {
+        close(epoll_);
+    }
+    if (wakeup_ != -1) {
+        close(wakeup_);
+    }
+}
+
+bool exit_watcher::watch(int pid) {
+    if (!running_ || pid <= 0) {
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (watched_.contains(pid)) {
+        return true;
+    }
+
+    const int fd = open_pidfd(pid);
+    if (fd == -1) {
+        return false;
+    }
+
+    // pidfd becomes readable when the process exits
+    epoll_event event = {};
+    event.events      = EPOLLIN;
+    event.data.fd     = pid;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) == -1) {
+        close(fd);
+        return false;
+    }
+    watched_.emplace(pid, fd);
+    return true;
+}
+
+void exit_watcher::unwatch(int pid) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+
+    const auto it = watched_.find(pid);
+    if (it == watched_.end()) {
+        return;
+    }
+    epoll_ctl(epoll_, EPOLL_CTL_DEL, it->second, nullptr);
+    close(it->second);
+    watched_.erase(it);
+}
+
+void exit_watcher::clear() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    for (const auto &[pid, fd]: watched_) {
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+    }
+    watched_.clear();
+}
+
+bool exit_watcher::watching(int pid) const {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    return watched_.contains(pid);
+}
+
+void exit_watcher::wait_thread() {
+    constexpr int                       max_events = 64;
+    std::array<epoll_event, max_events> events     = {};
+
+    while (running_) {
+        const int count = epoll_wait(epoll_, events.data(), max_events, -1);
+        if (count == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        const time_point exit_time = std::chrono::system_clock::now();
+        for (int i = 0; i < count; i++) {
+            const int pid = events[i].data.fd;
+            if (pid == -1) { // stopped
+                return;
+            }
+
+            // the process could be unwatched while waiting
+            {
+                const std::lock_guard<std::mutex> lock{mutex_};
+                const auto                        it = watched_.find(pid);
+                if (it == watched_.end()) {
+                    continue;
+                }
+                epoll_ctl(epoll_, EPOLL_CTL_DEL, it->second, nullptr);
+                close(it->second);
+                watched_.erase(it);
+            }
+
+            // the callback is called without the lock, so it can watch and unwatch processes
+            callback_(pid, exit_time);
+        }
+    }
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include "exit_watcher.hpp"
+
+// exits aren't reported on Windows, the sampler closes the intervals of exited processes at its next cycle
+
+namespace apptime {
+exit_watcher::exit_watcher(callback_type callback) : callback_{std::move(callback)} {}
+
+exit_watcher::~exit_watcher() = default;
+
+bool exit_watcher::watch(int /*pid*/) {
+    return false;
+}
+
+void exit_watcher::unwatch(int /*pid*/) {}
+
+void exit_watcher::clear() {}
+
+bool exit_watcher::watching(int /*pid*/) const {
+    return false;
+}
+
+void exit_watcher::wait_thread() {}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef APPTIME_IDLE_DETECTOR_HPP
+#define APPTIME_IDLE_DETECTOR_HPP
+
+#include <chrono>
+#include <functional>
+
+namespace apptime {
+/// @brief The interface reports when the user leaves the machine and comes back.
+class idle_detector {
+public:
+    using time_point = std::chrono::system_clock::time_point;
+
+    /**
+     * @brief The function called when the idle state changes.
+     *
+     * @param idle true if the user is away, false if the user is back.
+     * @param since The time of the last input if the user is away, the time of the activity otherwise.
+     */
+    using idle_callback = std::function<void(bool idle, time_point since)>;
+
+    virtual ~idle_detector() = default;
+
+    /**
+     * @brief Set the function called when the idle state changes.
+     *
+     * The function is called from another thread, the detector doesn't poll. If the user is away already,
+     * the function is called by the calling thread before `on_idle_change` returns.
+     *
+     * @param callback The function (empty to stop reporting).
+     */
+    virtual void on_idle_change(idle_callback callback) = 0;
+};
+} // namespace apptime
+
+#endif // APPTIME_IDLE_DETECTOR_HPP
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "logind_idle.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <systemd/sd-bus.h>
+#include <unistd.h>
+
+constexpr const char *logind_service   = "org.freedesktop.login1";
+constexpr const char *logind_path      = "/org/freedesktop/login1";
+constexpr const char *logind_manager   = "org.freedesktop.login1.Manager";
+constexpr const char *logind_session   = "org.freedesktop.login1.Session";
+constexpr const char *dbus_properties  = "org.freedesktop.DBus.Properties";
+constexpr const char *properties_event = "PropertiesChanged";
+
+// find the object path of the session of the process
+std::string logind_session_path(sd_bus *bus) {
+    sd_bus_error    error = SD_BUS_ERROR_NULL;
+    sd_bus_message *reply = nullptr;
+
+    // processes started by systemd --user aren't in the session, but they inherit its ID
+    int result = 0;
+    if (const char *id = std::getenv("XDG_SESSION_ID")) { // NOLINT(concurrency-mt-unsafe)
+        result = sd_bus_call_method(bus, logind_service, logind_path, logind_manager, "GetSession", &error, &reply, "s", id);
+    } else {
+        result = sd_bus_call_method(bus, logind_service, logind_path, logind_manager, "GetSessionByPID", &error, &reply, "u", getpid());
+    }
+
+    std::string path;
+    const char *object = nullptr;
+    if (result >= 0 && sd_bus_message_read(reply, "o", &object) >= 0) {
+        path = object;
+    }
+    sd_bus_message_unref(reply);
+    sd_bus_error_free(&error);
+    return path;
+}
+
+namespace apptime {
+std::unique_ptr<logind_idle> logind_idle::connect() {
+    sd_bus *bus = nullptr;
+    if (sd_bus_open_system(&bus) < 0) {
+        return nullptr;
+    }
+
+    std::string session = logind_session_path(bus);
+    if (session.empty()) {
+        sd_bus_flush_close_unref(bus);
+        return nullptr;
+    }
+
+    // the constructor is private, so std::make_unique can't be used
+    return std::unique_ptr<logind_idle>{new logind_idle{bus, std::move(session)}};
+}
+
+logind_idle::logind_idle(sd_bus *bus, std::string session)
+    : bus_{bus},
+      session_{std::move(session)},
+      wakeup_{eventfd(0, EFD_CLOEXEC)},
+      running_{false} {
+    // the bus is used only by the event thread after it's started
+    sd_bus_match_signal(bus_, &slot_, logind_service, session_.c_str(), dbus_properties, properties_event, &logind_idle::properties_changed, this);
+
+    update();
+    if (wakeup_ == -1) {
+        return;
+    }
+    running_ = true;
+    thread_  = std::thread{&logind_idle::event_thread, this};
+}
+
+logind_idle::~logind_idle() {
+    running_ = false;
+    if (wakeup_ != -1) {
+        eventfd_write(wakeup_, 1);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (wakeup_ != -1) {
+        close(wakeup_);
+    }
+    sd_bus_slot_unref(slot_);
+    sd_bus_flush_close_unref(bus_);
+}
+
+void logind_idle::on_idle_change(idle_callback callback) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    callback_ = std::move(callback);
+    if (idle_ && callback_) {
+        const idle_callback copy  = callback_;
+        const time_point    since = since_;
+        lock.unlock();
+        copy(true, since);
+    }
+}
+
+void logind_idle::event_thread() {
+    std::array<pollfd, 2> fds = {{
+        {.fd = sd_bus_get_fd(bus_), .events = 0, .revents = 0},
+        {.fd = wakeup_, .events = POLLIN, .revents = 0},
+    }};
+
+    while (running_) {
+        // dispatch all queued messages, the handler only marks the properties as changed
+        int processed = 0;
+        while ((processed = sd_bus_process(bus_, nullptr)) > 0) {
+        }
+        if (processed < 0) { // disconnected
+            break;
+        }
+
+        if (std::exchange(changed_, false) && update()) {
+            idle_callback callback;
+            bool          idle = false;
+            time_point    since;
+            {
+                const std::lock_guard<std::mutex> lock{mutex_};
+                callback = callback_;
+                idle     = idle_;
+                since    = since_;
+            }
+            if (callback) {
+                callback(idle, since);
+            }
+        }
+
+        fds[0].events = static_cast<short>(sd_bus_get_events(bus_));
+        if (poll(fds.data(), fds.size(), -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) { // stopped
+            break;
+        }
+    }
+}
+
+bool logind_idle::update() {
+    sd_bus_error  error      = SD_BUS_ERROR_NULL;
+    int           hint       = 0;
+    std::uint64_t since_hint = 0;
+
+    const char *path = session_.c_str();
+    bool        read = sd_bus_get_property_trivial(bus_, logind_service, path, logind_session, "IdleHint", &error, 'b', &hint) >= 0;
+    read             = read && sd_bus_get_property_trivial(bus_, logind_service, path, logind_session, "IdleSinceHint", &error, 't', &since_hint) >= 0;
+    sd_bus_error_free(&error);
+    if (!read) {
+        return false;
+    }
+
+    // IdleSinceHint is the time of the last change in microseconds of CLOCK_REALTIME
+    const bool       idle  = hint != 0;
+    const time_point since = since_hint ? time_point{std::chrono::microseconds{static_cast<std::int64_t>(since_hint)}} : std::chrono::system_clock::now();
+
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (idle == idle_) {
+        return false;
+    }
+    idle_  = idle;
+    since_ = since;
+    return true;
+}
+
+int logind_idle::properties_changed(sd_bus_message * /*message*/, void *userdata, sd_bus_error * /*error*/) {
+    // the properties are read after the dispatch, so a burst of signals costs one read
+    static_cast<logind_idle *>(userdata)->changed_ = true;
+    return 0;
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef APPTIME_LOGIND_IDLE_HPP
+#define APPTIME_LOGIND_IDLE_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "idle_detector.hpp"
+
+struct sd_bus;
+struct sd_bus_slot;
+struct sd_bus_message;
+struct sd_bus_error;
+
+namespace apptime {
+/**
+ * @brief The class detects idle by the `IdleHint` property of the logind session, which is set by the desktop environment.
+ *
+ * The session is found by `XDG_SESSION_ID` or by the process ID. `PropertiesChanged` signals of the session are received
+ * on the system bus by a separate thread, which sleeps in `poll` between them.
+ */
+class logind_idle : public idle_detector {
+public:
+    /**
+     * @brief Connect to logind.
+     *
+     * @return std::unique_ptr<logind_idle> The detector, or nullptr if the system bus or the session isn't available.
+     */
+    static std::unique_ptr<logind_idle> connect();
+
+    ~logind_idle() override;
+
+    logind_idle(const logind_idle &)            = delete;
+    logind_idle &operator=(const logind_idle &) = delete;
+
+    void on_idle_change(idle_callback callback) override;
+
+private:
+    logind_idle(sd_bus *bus, std::string session);
+
+    /// @brief Receive D-Bus messages until the detector is destroyed.
+    void event_thread();
+
+    /**
+     * @brief Read the idle properties of the session and update the idle state.
+     *
+     * @return true if the idle state changed, false otherwise.
+     */
+    bool update();
+
+    /// @brief The handler of `PropertiesChanged` signals of the session.
+    static int properties_changed(sd_bus_message *message, void *userdata, sd_bus_error *error);
+
+    sd_bus      *bus_;
+    std::string  session_;
+    sd_bus_slot *slot_ = nullptr;
+
+    /// @brief The eventfd used to wake up the event thread.
+    int wakeup_ = -1;
+    /// @brief Set by the signal handler, used only by the event thread.
+    bool changed_ = false;
+
+    std::mutex    mutex_;
+    bool          idle_ = false;
+    time_point    since_;
+    idle_callback callback_;
+
+    std::thread      thread_;
+    std::atomic_bool running_;
+};
+} // namespace apptime
+
+#endif // APPTIME_LOGIND_IDLE_HPP
\ No newline at end of file
@@ -2,9 +2,15 @@
 #define APPTIME_PROCESS_HPP
 
 #include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "process_buffer.hpp"
+
 namespace apptime {
 /// @brief The interface represent a system process and provides functionality to get information about it.
 class process {
@@ -47,6 +53,40 @@ public:
     virtual std::chrono::system_clock::time_point focused_start() const = 0;
 };
 
+/// @brief Information about a process collected in a single pass (see process_mgr::snapshot).
+struct process_info {
+    /// @brief The process ID (-1 if unknown).
+    int pid = -1;
+    /// @brief The parent process ID (-1 if unknown).
+    int ppid = -1;
+    /// @brief The window name associated with the process.
+    std::string window_name;
+    /// @brief The version of the window name, it changes only when the name changes (0 if unknown).
+    std::uint64_t name_version = 0;
+    /// @brief The full path of the executable associated with the process.
+    std::string full_path;
+    /// @brief The ID of the executable, processes with the same ID belong to the same application (0 if unknown, see exe_cache).
+    std::uint32_t exe_id = 0;
+    /// @brief The identity of the executable (zeros if unknown).
+    exe_identity exe{};
+    /// @brief The start time of the process.
+    std::chrono::system_clock::time_point start;
+    /// @brief The CPU time (user and system) consumed by the process so far (0 if not sampled).
+    std::chrono::milliseconds cpu_time{0};
+    /// @brief The resident set size of the process in bytes (0 if not sampled).
+    std::uint64_t rss = 0;
+};
+
+/// @brief The processes collected by a process manager (see process_mgr::scan_scope).
+struct process_scope {
+    /// @brief Collect only processes of the user that runs the application.
+    bool current_user = false;
+    /// @brief Collect only processes of a cgroup v2 subtree relative to the cgroup root, e.g. "/user.slice/user-1000.slice" (empty for all).
+    std::filesystem::path cgroup;
+
+    bool operator==(const process_scope &) const = default;
+};
+
 class process_mgr {
 public:
     virtual ~process_mgr() = default;
@@ -75,6 +115,69 @@ public:
      * @return process_type A process that has a focused window.
      */
     virtual process_type focused_window() = 0;
+
+    /**
+     * @brief Set the function called when the focused window changes.
+     *
+     * The function can be called from another thread. The default implementation doesn't report changes, so the focus has to be polled.
+     *
+     * @param callback The function.
+     * @return true if changes are reported, false otherwise.
+     */
+    virtual bool on_focus_change(std::function<void()> /*callback*/) { return false; }
+
+    /**
+     * @brief Set the number of threads used to collect information about processes.
+     *
+     * The default implementation ignores it, the information is collected by the calling thread.
+     *
+     * @param count The number of threads including the calling one.
+     */
+    virtual void scan_workers(unsigned /*count*/) {}
+
+    /**
+     * @brief Limit the processes collected by `snapshot`, so processes of other users and services aren't resolved at all.
+     *
+     * The default implementation ignores it, all processes are collected.
+     *
+     * @param scope The scope.
+     */
+    virtual void scan_scope(const process_scope & /*scope*/) {}
+
+    /**
+     * @brief Get information about all active processes that have a window.
+     *
+     * Unlike `active_windows`, the information is collected at once, so the caller doesn't need to query each process separately.
+     * The default implementation builds the snapshot from `active_windows` using the `process` getters.
+     *
+     * @param only_visible Get only visible windows.
+     *
+     * @return std::vector<process_info> A vector of information about active windows.
+     */
+    virtual std::vector<process_info> snapshot(bool only_visible) {
+        std::vector<process_info> result;
+        for (const auto &proc: active_windows(only_visible)) {
+            result.push_back({.window_name = proc->window_name(), .full_path = proc->full_path(), .start = proc->start()});
+        }
+        return result;
+    }
+
+    /**
+     * @brief Fill a caller-owned buffer with information about all active processes that have a window.
+     *
+     * Unlike the vector version, a buffer that is reused between calls doesn't allocate memory once it has grown to the usual size.
+     * The default implementation copies the vector version into the buffer.
+     * It can be called concurrently with `focused_window`.
+     *
+     * @param only_visible Get only visible windows.
+     * @param buffer The buffer, it's cleared before filling.
+     */
+    virtual void snapshot(bool only_visible, process_buffer &buffer) {
+        buffer.clear();
+        for (const auto &info: snapshot(only_visible)) {
+            buffer.push_back(info);
+        }
+    }
 };
 } // namespace apptime
 
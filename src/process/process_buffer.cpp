@@ -0,0 +1,57 @@
+#include "process_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "process.hpp"
+
+namespace apptime {
+void process_buffer::clear() {
+    entries_.clear();
+    current_ = 0;
+    used_    = 0;
+}
+
+process_entry &process_buffer::push_back(process_entry entry) {
+    process_entry &result = entries_.emplace_back(entry);
+    result.window_name    = store(entry.window_name);
+    result.full_path      = store(entry.full_path);
+    return result;
+}
+
+process_entry &process_buffer::push_back(const process_info &info) {
+    return push_back(process_entry{
+        .pid          = info.pid,
+        .ppid         = info.ppid,
+        .window_name  = info.window_name,
+        .name_version = info.name_version,
+        .full_path    = info.full_path,
+        .exe_id       = info.exe_id,
+        .exe          = info.exe,
+        .start        = info.start,
+        .cpu_time     = info.cpu_time,
+        .rss          = info.rss,
+    });
+}
+
+std::string_view process_buffer::store(std::string_view str) {
+    if (str.empty()) {
+        return {};
+    }
+
+    // skip the blocks that are too small, they are used again after the next clear
+    while (current_ < blocks_.size() && used_ + str.size() > blocks_[current_].size) {
+        current_++;
+        used_ = 0;
+    }
+    if (current_ == blocks_.size()) {
+        const std::size_t size = std::max(block_size, str.size());
+        blocks_.push_back({.data = std::make_unique_for_overwrite<char[]>(size), .size = size}); // NOLINT(*-avoid-c-arrays)
+    }
+
+    char *data = blocks_[current_].data.get() + used_;
+    std::memcpy(data, str.data(), str.size());
+    used_ += str.size();
+    return {data, str.size()};
+}
+} // namespace apptime
\ No newline at end of file
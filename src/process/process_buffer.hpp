@@ -0,0 +1,118 @@
+#ifndef APPTIME_PROCESS_BUFFER_HPP
+#define APPTIME_PROCESS_BUFFER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace apptime {
+struct process_info;
+
+/// @brief The identity of an executable file, it's kept when the file is renamed and changes when the file is replaced or modified.
+struct exe_identity {
+    /// @brief The device of the file system.
+    std::uint64_t device = 0;
+    /// @brief The inode of the file.
+    std::uint64_t inode = 0;
+    /// @brief The modification time of the file in nanoseconds since the epoch.
+    std::int64_t mtime = 0;
+
+    bool operator==(const exe_identity &) const = default;
+};
+
+/// @brief A plain process descriptor stored in a process_buffer, the strings point into the arena of the buffer.
+struct process_entry {
+    /// @brief The process ID (-1 if unknown).
+    int pid = -1;
+    /// @brief The parent process ID (-1 if unknown).
+    int ppid = -1;
+    /// @brief The window name associated with the process.
+    std::string_view window_name;
+    /// @brief The version of the window name, it changes only when the name changes (0 if unknown).
+    std::uint64_t name_version = 0;
+    /// @brief The full path of the executable associated with the process.
+    std::string_view full_path;
+    /// @brief The ID of the executable, processes with the same ID belong to the same application (0 if unknown, see exe_cache).
+    std::uint32_t exe_id = 0;
+    /// @brief The identity of the executable (zeros if unknown).
+    exe_identity exe{};
+    /// @brief The start time of the process.
+    std::chrono::system_clock::time_point start;
+    /// @brief The CPU time (user and system) consumed by the process so far (0 if not sampled).
+    std::chrono::milliseconds cpu_time{0};
+    /// @brief The resident set size of the process in bytes (0 if not sampled).
+    std::uint64_t rss = 0;
+};
+
+/**
+ * @brief The class is a caller-owned, reusable buffer of process descriptors (see process_mgr::snapshot).
+ *
+ * Strings are copied into an arena of fixed-size blocks. Clearing the buffer keeps the descriptors capacity and the blocks,
+ * so a buffer that is reused for snapshots of a similar size doesn't allocate memory.
+ *
+ * @warning The strings of descriptors are valid until the buffer is cleared or destroyed.
+ */
+class process_buffer {
+public:
+    /// @brief The size of an arena block, longer strings get a block of their own.
+    static constexpr std::size_t block_size = 16 * 1024;
+
+    /// @brief Remove all descriptors, the memory is kept for reuse.
+    void clear();
+
+    /**
+     * @brief Add a process descriptor, the strings are copied into the arena.
+     *
+     * @param entry The descriptor.
+     * @return process_entry& The added descriptor.
+     */
+    process_entry &push_back(process_entry entry);
+
+    /**
+     * @brief Add a process descriptor, the strings are copied into the arena.
+     *
+     * @param info The information about the process.
+     * @return process_entry& The added descriptor.
+     */
+    process_entry &push_back(const process_info &info);
+
+    /**
+     * @brief Copy a string into the arena.
+     *
+     * @param str The string.
+     * @return std::string_view The copy valid until the buffer is cleared.
+     */
+    std::string_view store(std::string_view str);
+
+    std::span<process_entry>       entries() { return entries_; }
+    std::span<const process_entry> entries() const { return entries_; }
+
+    std::size_t size() const { return entries_.size(); }
+    bool        empty() const { return entries_.empty(); }
+
+    auto begin() { return entries_.begin(); }
+    auto end() { return entries_.end(); }
+    auto begin() const { return entries_.begin(); }
+    auto end() const { return entries_.end(); }
+
+private:
+    /// @brief An arena block.
+    struct block {
+        std::unique_ptr<char[]> data; // NOLINT(*-avoid-c-arrays)
+        std::size_t             size = 0;
+    };
+
+    std::vector<process_entry> entries_;
+
+    std::vector<block> blocks_;
+    /// @brief The index of the block that is being filled.
+    std::size_t current_ = 0;
+    /// @brief The used size of the current block.
+    std::size_t used_ = 0;
+};
+} // namespace apptime
+
+#endif // APPTIME_PROCESS_BUFFER_HPP
\ No newline at end of file
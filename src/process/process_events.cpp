@@ -0,0 +1,77 @@
+#include "process_events.hpp"
+
+#include <bit>
+#include <cerrno>
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+
+namespace apptime {
+void process_events::handle(const char *data, std::size_t size) {
+    auto *header = std::bit_cast<const nlmsghdr *>(data);
+    auto  length = static_cast<int>(size);
+    for (; NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+        if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) {
+            continue;
+        }
+
+        const auto *message = static_cast<const cn_msg *>(NLMSG_DATA(header));
+        if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) {
+            continue;
+        }
+        const auto *event = std::bit_cast<const proc_event *>(&message->data[0]);
+
+        // threads are reported too, only the main threads are interesting
+        switch (event->what) {
+        case proc_event::PROC_EVENT_FORK:
+        case proc_event::PROC_EVENT_EXEC: {
+            const bool fork = event->what == proc_event::PROC_EVENT_FORK;
+            const int  pid  = fork ? event->event_data.fork.child_pid : event->event_data.exec.process_pid;
+            const int  tgid = fork ? event->event_data.fork.child_tgid : event->event_data.exec.process_tgid;
+            if (pid != tgid) {
+                break;
+            }
+
+            // exec changes the executable of the process, so both events are resolved from procfs
+            // a process that can't be resolved has exited or has left the scope (e.g. by exec of a setuid executable)
+            process_info                      info;
+            const bool                        found = scanner_.resolve(pid, info);
+            const std::lock_guard<std::mutex> lock{mutex_};
+            if (found) {
+                table_.insert_or_assign(pid, std::move(info));
+            } else {
+                table_.erase(pid);
+            }
+            break;
+        }
+        case proc_event::PROC_EVENT_EXIT: {
+            if (event->event_data.exit.process_pid != event->event_data.exit.process_tgid) {
+                break;
+            }
+            const std::lock_guard<std::mutex> lock{mutex_};
+            table_.erase(event->event_data.exit.process_pid);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void process_events::receive_failed(int error) {
+    if (error == ENOBUFS) {
+        resync();
+    }
+}
+
+void process_events::resync() {
+    std::unordered_map<int, process_info> table;
+    for (auto &info: scanner_.scan()) {
+        table.emplace(info.pid, std::move(info));
+    }
+
+    const std::lock_guard<std::mutex> lock{mutex_};
+    table_ = std::move(table);
+}
+} // namespace apptime
\ No newline at end of file
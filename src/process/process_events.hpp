@@ -0,0 +1,65 @@
+#ifndef APPTIME_PROCESS_EVENTS_HPP
+#define APPTIME_PROCESS_EVENTS_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "process.hpp"
+#include "procfs_scanner.hpp"
+
+namespace apptime {
+/**
+ * @brief The process table updated by fork/exec/exit events of the netlink process connector.
+ *
+ * The table doesn't own the socket, it's fed with received datagrams, so it can be tested with synthetic messages.
+ * New and replaced processes are resolved by the scanner, which is used only by the thread that feeds the table.
+ */
+class process_events {
+public:
+    /**
+     * @brief Construct an empty table.
+     *
+     * @param scanner The scanner that resolves processes.
+     */
+    explicit process_events(procfs_scanner &scanner) : scanner_{scanner} {}
+
+    /**
+     * @brief Apply a received datagram to the table.
+     *
+     * @param data The datagram, a sequence of netlink messages with a `cn_msg` and a `proc_event` each.
+     * @param size The size of the datagram.
+     */
+    void handle(const char *data, std::size_t size);
+
+    /**
+     * @brief Handle a failed receive.
+     *
+     * @param error The error number, ENOBUFS means the receive buffer overflowed and events were lost, so the table is rebuilt.
+     */
+    void receive_failed(int error);
+
+    /// @brief Replace the table with a full procfs scan.
+    void resync();
+
+    /**
+     * @brief Read the table under its lock.
+     *
+     * @param fn The function called with `const std::unordered_map<int, process_info> &`, processes by process ID.
+     */
+    template <typename Fn>
+    void read(Fn &&fn) const {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        std::forward<Fn>(fn)(table_);
+    }
+
+private:
+    procfs_scanner &scanner_;
+
+    mutable std::mutex                    mutex_;
+    std::unordered_map<int, process_info> table_;
+};
+} // namespace apptime
+
+#endif // APPTIME_PROCESS_EVENTS_HPP
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "process_netlink.hpp"
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// the size of the subscription message: netlink header, connector header and the operation
+constexpr std::size_t mcast_message_size = NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+
+namespace apptime {
+process_netlink_mgr::process_netlink_mgr() : process_netlink_mgr{subscribe(), "/proc"} {}
+
+process_netlink_mgr::process_netlink_mgr(int socket, const std::filesystem::path &procfs_root) : process_system_mgr{procfs_root}, running_{false} {
+    if (socket == -1) {
+        return;
+    }
+    wakeup_ = eventfd(0, EFD_CLOEXEC);
+    if (wakeup_ == -1) {
+        close(socket);
+        return;
+    }
+    socket_ = socket;
+
+    // subscribe before the initial scan, so processes spawned in between aren't lost
+    events_.resync();
+    running_ = true;
+    thread_  = std::thread{&process_netlink_mgr::listen_thread, this};
+}
+
+process_netlink_mgr::~process_netlink_mgr() {
+    running_ = false;
+    if (wakeup_ != -1) {
+        eventfd_write(wakeup_, 1);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (socket_ != -1) {
+        close(socket_);
+    }
+    if (wakeup_ != -1) {
+        close(wakeup_);
+    }
+}
+
+std::vector<process_mgr::process_type> process_netlink_mgr::active_processes() {
+    if (!listening()) {
+        return process_system_mgr::active_processes();
+    }
+
+    std::vector<process_type> result;
+    events_.read([&](const auto &table) {
+        for (const auto &[pid, info]: table) {
+            result.emplace_back(std::make_unique<process_system>(pid));
+        }
+    });
+    return result;
+}
+
+std::vector<process_mgr::process_type> process_netlink_mgr::active_windows(bool only_visible) {
+#ifdef APPTIME_X11
+    // windows are listed by X11 without procfs
+    if (x11_) {
+        return process_system_mgr::active_windows(only_visible);
+    }
+#endif
+    if (!listening()) {
+        return process_system_mgr::active_windows(only_visible);
+    }
+    return active_processes();
+}
+
+std::vector<process_info> process_netlink_mgr::snapshot(bool only_visible) {
+    if (!listening()) {
+        return process_system_mgr::snapshot(only_visible);
+    }
+
+#ifdef APPTIME_X11
+    if (x11_) {
+        // windows are requested before locking, so events aren't blocked by round-trips
+        auto windows = x11_->process_windows(only_visible);
+
+        std::vector<process_info> result;
+        events_.read([&](const auto &table) {
+            for (auto &win: windows) {
+                if (const auto it = table.find(win.pid); it != table.end()) {
+                    process_info &info = result.emplace_back(it->second);
+                    info.window_name   = std::move(win.name);
+                    info.name_version  = win.name_version;
+                }
+            }
+        });
+        scanner_.sample(result);
+        return result;
+    }
+#endif
+
+    std::vector<process_info> result;
+    events_.read([&](const auto &table) {
+        result.reserve(table.size());
+        for (const auto &[pid, info]: table) {
+            result.push_back(info);
+        }
+    });
+
+    // the table is updated by events only, so the usage is read after the lock is released
+    scanner_.sample(result);
+    return result;
+}
+
+void process_netlink_mgr::snapshot(bool only_visible, process_buffer &buffer) {
+    if (!listening()) {
+        process_system_mgr::snapshot(only_visible, buffer);
+        return;
+    }
+
+    buffer.clear();
+#ifdef APPTIME_X11
+    if (x11_) {
+        // windows are requested before locking, so events aren't blocked by round-trips
+        const auto windows = x11_->process_windows(only_visible);
+
+        events_.read([&](const auto &table) {
+            for (const auto &win: windows) {
+                if (const auto it = table.find(win.pid); it != table.end()) {
+                    process_entry &entry = buffer.push_back(it->second);
+                    entry.window_name    = buffer.store(win.name);
+                    entry.name_version   = win.name_version;
+                }
+            }
+        });
+        scanner_.sample(buffer.entries());
+        return;
+    }
+#endif
+
+    events_.read([&](const auto &table) {
+        for (const auto &[pid, info]: table) {
+            buffer.push_back(info);
+        }
+    });
+
+    // the table is updated by events only, so the usage is read after the lock is released
+    scanner_.sample(buffer.entries());
+}
+
+void process_netlink_mgr::scan_scope(const process_scope &scope) {
+    if (!listening()) {
+        process_system_mgr::scan_scope(scope);
+        return;
+    }
+
+    // the scanner belongs to the listener thread
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        scope_ = scope;
+    }
+    eventfd_write(wakeup_, 1);
+}
+
+int process_netlink_mgr::subscribe() {
+    const int sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (sock == -1) {
+        return -1;
+    }
+
+    sockaddr_nl addr = {};
+    addr.nl_family   = AF_NETLINK;
+    addr.nl_groups   = CN_IDX_PROC;
+
+    alignas(nlmsghdr) std::array<char, mcast_message_size> request = {};
+
+    auto *header       = std::bit_cast<nlmsghdr *>(request.data());
+    header->nlmsg_len  = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid  = static_cast<__u32>(getpid());
+
+    auto *message   = static_cast<cn_msg *>(NLMSG_DATA(header));
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len    = sizeof(proc_cn_mcast_op);
+
+    const proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(&message->data[0], &op, sizeof(op));
+
+    // joining the multicast group requires CAP_NET_ADMIN
+    if (bind(sock, std::bit_cast<const sockaddr *>(&addr), sizeof(addr)) == -1 || send(sock, request.data(), header->nlmsg_len, 0) == -1) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+void process_netlink_mgr::apply_scope() {
+    std::optional<process_scope> scope;
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        scope.swap(scope_);
+    }
+    if (scope) {
+        scanner_.scope(*scope);
+        events_.resync();
+    }
+}
+
+void process_netlink_mgr::listen_thread() {
+    alignas(nlmsghdr) std::array<char, 8192> buffer = {};
+    std::array<pollfd, 2>                    fds    = {{
+        {.fd = socket_, .events = POLLIN, .revents = 0},
+        {.fd = wakeup_, .events = POLLIN, .revents = 0},
+    }};
+
+    while (running_) {
+        if (poll(fds.data(), fds.size(), -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) { // stopped or the scope is changed
+            eventfd_t value = 0;
+            eventfd_read(wakeup_, &value);
+            if (!running_) {
+                break;
+            }
+            apply_scope();
+            continue;
+        }
+
+        const ssize_t len = recv(socket_, buffer.data(), buffer.size(), 0);
+        if (len == -1) {
+            events_.receive_failed(errno);
+            continue;
+        }
+        events_.handle(buffer.data(), static_cast<std::size_t>(len));
+    }
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef APPTIME_PROCESS_NETLINK_HPP
+#define APPTIME_PROCESS_NETLINK_HPP
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "process_events.hpp"
+#include "process_system.hpp"
+
+namespace apptime {
+/**
+ * @brief The process manager that tracks processes by fork/exec/exit events of the netlink process connector.
+ *
+ * The process table is kept in memory and updated by a listener thread, so queries don't touch procfs.
+ * If the connector socket can't be opened (e.g. without CAP_NET_ADMIN), the manager falls back to `process_system_mgr` polling.
+ */
+class process_netlink_mgr : public process_system_mgr {
+public:
+    /// @brief Subscribe to process events and fill the process table.
+    process_netlink_mgr();
+
+    /**
+     * @brief Receive process events from an opened socket and fill the process table.
+     *
+     * @param socket The connector socket, the manager takes ownership of it (-1 falls back to polling).
+     * @param procfs_root The procfs mount point, another directory can be used for testing.
+     */
+    process_netlink_mgr(int socket, const std::filesystem::path &procfs_root);
+    ~process_netlink_mgr() override;
+
+    process_netlink_mgr(const process_netlink_mgr &)            = delete;
+    process_netlink_mgr &operator=(const process_netlink_mgr &) = delete;
+
+    /**
+     * @brief Check if the manager receives process events.
+     *
+     * @return true if the events are received, false if the manager falls back to polling.
+     */
+    bool listening() const { return socket_ != -1; }
+
+    /**
+     * @brief Get a list of all active processes.
+     *
+     * @return std::vector<process_type> A vector of active processes.
+     */
+    std::vector<process_type> active_processes() override;
+
+    /**
+     * @brief Get a list of all active processes that have a window.
+     *
+     * @param only_visible Get only visible windows.
+     *
+     * @return std::vector<process_type> A vector of active windows.
+     */
+    std::vector<process_type> active_windows(bool only_visible) override;
+
+    /**
+     * @brief Get information about all active processes that have a window.
+     *
+     * @param only_visible Get only visible windows.
+     *
+     * @return std::vector<process_info> A vector of information about active windows.
+     */
+    std::vector<process_info> snapshot(bool only_visible) override;
+
+    /**
+     * @brief Fill a caller-owned buffer with information about all active processes that have a window.
+     *
+     * @param only_visible Get only visible windows.
+     * @param buffer The buffer, it's cleared before filling.
+     */
+    void snapshot(bool only_visible, process_buffer &buffer) override;
+
+    /**
+     * @brief Limit the processes of the table to the current user or a cgroup subtree.
+     *
+     * The scope is applied by the listener thread, which rebuilds the table with a full procfs scan.
+     *
+     * @param scope The scope.
+     */
+    void scan_scope(const process_scope &scope) override;
+
+    /**
+     * @brief Open the connector socket and subscribe to process events.
+     *
+     * @return int The socket, -1 if the subscription fails (e.g. without CAP_NET_ADMIN).
+     */
+    static int subscribe();
+
+private:
+    /// @brief Apply the scope requested by scan_scope and rebuild the process table.
+    void apply_scope();
+
+    /// @brief Receive process events until the manager is destroyed.
+    void listen_thread();
+
+    /// @brief The netlink connector socket (-1 if the manager falls back to polling).
+    int socket_ = -1;
+    /// @brief The eventfd used to wake up the listener thread.
+    int wakeup_ = -1;
+
+    std::thread      thread_;
+    std::atomic_bool running_;
+
+    /// @brief The process table, it's updated by the listener thread only.
+    process_events events_{scanner_};
+
+    std::mutex mutex_;
+    /// @brief The scope waiting to be applied by the listener thread.
+    std::optional<process_scope> scope_;
+};
+} // namespace apptime
+
+#endif // APPTIME_PROCESS_NETLINK_HPP
\ No newline at end of file
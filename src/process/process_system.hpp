@@ -3,6 +3,13 @@
 
 #include "process.hpp"
 
+#ifndef _WIN32
+#include "procfs_scanner.hpp"
+#endif
+#ifdef APPTIME_X11
+#include "x11_session.hpp"
+#endif
+
 namespace apptime {
 /// @brief The class represent a system process and provides functionality to get information about it
 /// using WinAPI for Windows and POSIX for Linux.
@@ -46,7 +53,7 @@ public:
     /**
      * @brief Get the start time of the focused window.
      *
-     * @warning For Windows, this function must be used in conjunction with `process::focused_window`.
+     * @warning For Windows and X11, this function must be used in conjunction with `process::focused_window`.
      *
      * @return std::chrono::system_clock::time_point The start time of the focused window.
      */
@@ -55,9 +62,11 @@ public:
 private:
     /// @brief The process ID.
     int process_id_;
-#ifdef _WIN32
     /// @brief The start time of the focused window (see process::focused_start).
     std::chrono::system_clock::time_point focused_start_;
+#ifndef _WIN32
+    /// @brief The window name (see process::window_name).
+    std::string window_name_;
 #endif
 
     friend class process_system_mgr;
@@ -65,6 +74,15 @@ private:
 
 class process_system_mgr : public process_mgr {
 public:
+#ifndef _WIN32
+    /**
+     * @brief Construct a new manager. For X11, it connects to the display from the DISPLAY environment variable.
+     *
+     * @param procfs_root The procfs mount point used by snapshot, another directory can be used for testing.
+     */
+    explicit process_system_mgr(const std::filesystem::path &procfs_root = "/proc");
+#endif
+
     /**
      * @brief Get a list of all active processes.
      *
@@ -87,6 +105,66 @@ public:
      * @return process_type A process that has a focused window.
      */
     process_type focused_window() override;
+
+    /**
+     * @brief Set the function called when the focused window changes.
+     *
+     * For X11, changes are reported by `_NET_ACTIVE_WINDOW` events. For other platforms, changes aren't reported.
+     *
+     * @param callback The function.
+     * @return true if changes are reported, false otherwise.
+     */
+    bool on_focus_change(std::function<void()> callback) override;
+
+    /**
+     * @brief Get information about all active processes that have a window.
+     *
+     * For Linux, the information is collected in a single walk of procfs.
+     * For X11, only processes that own a client window are resolved.
+     *
+     * @param only_visible Get only visible windows.
+     *
+     * @return std::vector<process_info> A vector of information about active windows.
+     */
+    std::vector<process_info> snapshot(bool only_visible) override;
+
+    /**
+     * @brief Fill a caller-owned buffer with information about all active processes that have a window.
+     *
+     * For Linux, known processes are copied from the table of the procfs scanner, so a reused buffer doesn't allocate memory.
+     *
+     * @param only_visible Get only visible windows.
+     * @param buffer The buffer, it's cleared before filling.
+     */
+    void snapshot(bool only_visible, process_buffer &buffer) override;
+
+#ifndef _WIN32
+    /**
+     * @brief Set the number of threads used to resolve new processes found by a walk of procfs.
+     *
+     * @param count The number of threads including the calling one.
+     */
+    void scan_workers(unsigned count) override { scanner_.workers(count); }
+
+    /**
+     * @brief Limit the processes collected by snapshot to the current user or a cgroup subtree.
+     *
+     * @param scope The scope.
+     */
+    void scan_scope(const process_scope &scope) override { scanner_.scope(scope); }
+#endif
+
+#ifndef _WIN32
+protected:
+    /// @brief The procfs scanner used by snapshot.
+    procfs_scanner scanner_;
+#endif
+#ifdef APPTIME_X11
+    /// @brief The X11 session (nullptr if there is no X11 server).
+    std::unique_ptr<x11_session> x11_;
+    /// @brief The process IDs of windows, reused by snapshot.
+    std::vector<int> pids_;
+#endif
 };
 } // namespace apptime
 
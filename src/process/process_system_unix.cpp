@@ -10,7 +10,7 @@ using namespace std::chrono;
 
 constexpr std::time_t invalid_time = static_cast<std::time_t>(-1);
 
-// TODO: X11/Wayland support for window_name, active_windows & focused_window?
+// TODO: Wayland support for window_name, active_windows & focused_window?
 
 std::time_t system_boot_time() {
     std::ifstream fp{"/proc/uptime"};
@@ -38,7 +38,7 @@ bool process_system::exist() const {
 }
 
 std::string process_system::window_name() const {
-    return {};
+    return window_name_;
 }
 
 std::string process_system::full_path() const {
@@ -72,11 +72,22 @@ system_clock::time_point process_system::start() const {
 }
 
 std::chrono::system_clock::time_point process_system::focused_start() const {
+    if (focused_start_ != system_clock::time_point{}) {
+        return focused_start_;
+    }
     return start();
 }
 
 // process_system_mgr
 
+process_system_mgr::process_system_mgr(const std::filesystem::path &procfs_root) : scanner_{procfs_root} {
+    // monitoring stores CPU time and memory of applications, the stat of known processes is read again by every snapshot
+    scanner_.usage(true);
+#ifdef APPTIME_X11
+    x11_ = x11_session::connect();
+#endif
+}
+
 std::vector<process_mgr::process_type> process_system_mgr::active_processes() {
     proc_t                    proc_info = {};
     std::vector<process_type> result;
@@ -92,11 +103,96 @@ std::vector<process_mgr::process_type> process_system_mgr::active_processes() {
     return result;
 }
 
-std::vector<process_mgr::process_type> process_system_mgr::active_windows(bool /*only_visible*/) {
+std::vector<process_mgr::process_type> process_system_mgr::active_windows([[maybe_unused]] bool only_visible) {
+#ifdef APPTIME_X11
+    if (x11_) {
+        std::vector<process_type> result;
+        for (auto &win: x11_->process_windows(only_visible)) {
+            auto proc          = std::make_unique<process_system>(win.pid);
+            proc->window_name_ = std::move(win.name);
+            result.emplace_back(std::move(proc));
+        }
+        return result;
+    }
+#endif
     return active_processes();
 }
 
 process_mgr::process_type process_system_mgr::focused_window() {
+#ifdef APPTIME_X11
+    if (x11_) {
+        const x11_session::focus focus = x11_->focused();
+
+        auto result            = std::make_unique<process_system>(focus.pid);
+        result->focused_start_ = focus.since;
+        return result;
+    }
+#endif
     return std::make_unique<process_system>(-1);
 }
+
+bool process_system_mgr::on_focus_change([[maybe_unused]] std::function<void()> callback) {
+#ifdef APPTIME_X11
+    if (x11_) {
+        x11_->on_focus_change(std::move(callback));
+        return true;
+    }
+#endif
+    return false;
+}
+
+std::vector<process_info> process_system_mgr::snapshot([[maybe_unused]] bool only_visible) {
+#ifdef APPTIME_X11
+    if (x11_) {
+        const auto       windows = x11_->process_windows(only_visible);
+        std::vector<int> pids;
+        pids.reserve(windows.size());
+        for (const auto &win: windows) {
+            pids.push_back(win.pid);
+        }
+
+        // processes are returned in the order of pids, the dead ones are skipped
+        std::vector<process_info> result = scanner_.scan(pids);
+        auto                      win    = windows.begin();
+        for (auto &info: result) {
+            while (win != windows.end() && win->pid != info.pid) {
+                win++;
+            }
+            if (win != windows.end()) {
+                info.window_name  = win->name;
+                info.name_version = win->name_version;
+            }
+        }
+        return result;
+    }
+#endif
+    return scanner_.scan();
+}
+
+void process_system_mgr::snapshot([[maybe_unused]] bool only_visible, process_buffer &buffer) {
+#ifdef APPTIME_X11
+    if (x11_) {
+        const auto windows = x11_->process_windows(only_visible);
+        pids_.clear();
+        for (const auto &win: windows) {
+            pids_.push_back(win.pid);
+        }
+
+        // processes are added in the order of pids, the dead ones are skipped
+        scanner_.scan(pids_, buffer);
+        auto win = windows.begin();
+        for (auto &entry: buffer) {
+            while (win != windows.end() && win->pid != entry.pid) {
+                win++;
+            }
+            if (win != windows.end()) {
+                entry.window_name  = buffer.store(win->name);
+                entry.name_version = win->name_version;
+            }
+        }
+        return;
+    }
+#endif
+    scanner_.scan(buffer);
+}
 } // namespace apptime
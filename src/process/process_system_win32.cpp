@@ -178,4 +178,25 @@ process_system_mgr::process_type process_system_mgr::focused_window() {
     }
     return std::make_unique<process_system>(last_focused);
 }
+
+bool process_system_mgr::on_focus_change(std::function<void()> /*callback*/) {
+    return false;
+}
+
+std::vector<process_info> process_system_mgr::snapshot(bool only_visible) {
+    std::vector<process_info> result;
+    for (const auto &win: active_windows(only_visible)) {
+        const auto &proc = static_cast<const process_system &>(*win);
+        result.push_back({.pid = proc.process_id_, .window_name = proc.window_name(), .full_path = proc.full_path(), .start = proc.start()});
+    }
+    return result;
+}
+
+void process_system_mgr::snapshot(bool only_visible, process_buffer &buffer) {
+    buffer.clear();
+    for (const auto &win: active_windows(only_visible)) {
+        const auto &proc = static_cast<const process_system &>(*win);
+        buffer.push_back(process_info{.pid = proc.process_id_, .window_name = proc.window_name(), .full_path = proc.full_path(), .start = proc.start()});
+    }
+}
 } // namespace apptime
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "process_tree.hpp"
+
+#include <algorithm>
+
+namespace apptime {
+void process_tree::fold(process_buffer &buffer) {
+    const auto entries = buffer.entries();
+
+    index_.clear();
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        index_.emplace_back(entries[i].pid, i);
+    }
+    std::ranges::sort(index_);
+
+    // the roots are found before any entry is changed, the rules match the original executables
+    targets_.resize(entries.size());
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        targets_[i] = i;
+
+        std::size_t root  = i;
+        std::size_t rule  = match(entries[root].full_path);
+        int         depth = 0;
+        for (; rule == npos && depth < max_depth; depth++) {
+            root = parent(entries, root);
+            if (root == npos) {
+                break;
+            }
+            rule = match(entries[root].full_path);
+        }
+        if (rule == npos) {
+            continue;
+        }
+
+        // climb while the ancestors are the same application
+        for (std::size_t up = parent(entries, root); up != npos && depth < max_depth && match(entries[up].full_path) == rule; depth++) {
+            root = up;
+            up   = parent(entries, up);
+        }
+        targets_[i] = root;
+    }
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (targets_[i] == i) {
+            continue;
+        }
+
+        // the strings point into the arena of the same buffer
+        const process_entry &root  = entries[targets_[i]];
+        process_entry       &entry = entries[i];
+        entry.pid            = root.pid;
+        entry.ppid           = root.ppid;
+        entry.window_name    = root.window_name;
+        entry.name_version   = root.name_version;
+        entry.full_path      = root.full_path;
+        entry.exe_id         = root.exe_id;
+        entry.exe            = root.exe;
+        entry.start          = root.start;
+    }
+}
+
+std::size_t process_tree::match(std::string_view full_path) const {
+    for (std::size_t i = 0; i < roots_.size(); i++) {
+        const std::string_view root = roots_[i];
+        if (full_path == root || (root.ends_with('/') && full_path.starts_with(root))) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+std::size_t process_tree::parent(std::span<const process_entry> entries, std::size_t index) const {
+    const int ppid = entries[index].ppid;
+    if (ppid <= 0 || ppid == entries[index].pid) {
+        return npos;
+    }
+
+    const auto it = std::ranges::lower_bound(index_, std::pair{ppid, std::size_t{0}});
+    return it != index_.end() && it->first == ppid ? it->second : npos;
+}
+} // namespace apptime
\ No newline at end of file
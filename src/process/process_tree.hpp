@@ -0,0 +1,87 @@
+#ifndef APPTIME_PROCESS_TREE_HPP
+#define APPTIME_PROCESS_TREE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "process_buffer.hpp"
+
+namespace apptime {
+/**
+ * @brief The class attributes helper processes to the application that spawned them by the parent process IDs of a snapshot.
+ *
+ * A root rule is the full path of an executable, or a directory ending with '/' that matches all executables inside it.
+ * A process is attributed to its nearest ancestor (or itself) that matches a rule, and then to the top-most chain of ancestors
+ * that match the same rule. So helpers with other executables of the directory join the main process,
+ * while an application launched from another root (e.g. a terminal) stays on its own.
+ */
+class process_tree {
+public:
+    /// @brief The maximum number of ancestors visited for a process, it protects against cycles of stale parent IDs.
+    static constexpr int max_depth = 64;
+
+    /**
+     * @brief Set the root rules.
+     *
+     * @param roots The full paths of executables and directories ending with '/'.
+     */
+    void roots(std::vector<std::string> roots) { roots_ = std::move(roots); }
+
+    /**
+     * @brief Get the root rules.
+     *
+     * @return const std::vector<std::string>& The root rules.
+     */
+    const std::vector<std::string> &roots() const { return roots_; }
+
+    /**
+     * @brief Check if there are no rules, so nothing is attributed.
+     *
+     * @return true if there are no rules, false otherwise.
+     */
+    bool empty() const { return roots_.empty(); }
+
+    /**
+     * @brief Attribute the processes of a buffer to their root applications.
+     *
+     * The identity (pid, window name, executable and start) of an attributed process is replaced by the one of its root,
+     * so monitoring writes one interval per application and sums the usage of all of its processes.
+     * Only ancestors that are in the buffer are known, so the buffer should contain all processes, not only the ones with windows.
+     * The memory is kept between calls, so a reused tree doesn't allocate memory for snapshots of a similar size.
+     *
+     * @param buffer The processes.
+     */
+    void fold(process_buffer &buffer);
+
+private:
+    /**
+     * @brief Find the rule that matches an executable.
+     *
+     * @param full_path The full path of the executable.
+     * @return std::size_t The index of the rule, or `npos` if no rule matches.
+     */
+    std::size_t match(std::string_view full_path) const;
+
+    /**
+     * @brief Find the parent of a process in the buffer.
+     *
+     * @param entries The processes.
+     * @param index The index of the process.
+     * @return std::size_t The index of the parent, or `npos` if it isn't in the buffer.
+     */
+    std::size_t parent(std::span<const process_entry> entries, std::size_t index) const;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::vector<std::string> roots_;
+
+    /// @brief (pid, index) pairs of the buffer sorted by pid and the root index of every process, reused between calls.
+    std::vector<std::pair<int, std::size_t>> index_;
+    std::vector<std::size_t>                 targets_;
+};
+} // namespace apptime
+
+#endif // APPTIME_PROCESS_TREE_HPP
\ No newline at end of file
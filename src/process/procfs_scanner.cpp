@@ -0,0 +1,675 @@
+#include "procfs_scanner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+// read the system boot time from "btime" in /proc/stat, it doesn't drift like now - uptime
+system_clock::time_point procfs_boot_time(const std::filesystem::path &root) {
+    std::ifstream fp{root / "stat"};
+    for (std::string key; fp >> key;) {
+        if (key == "btime") {
+            std::time_t btime = 0;
+            if (fp >> btime) {
+                return system_clock::from_time_t(btime);
+            }
+            break;
+        }
+        fp.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+    // fallback to /proc/uptime
+    std::ifstream uptime_fp{root / "uptime"};
+    double        uptime = 0;
+    if (!(uptime_fp >> uptime)) {
+        return {};
+    }
+    return system_clock::from_time_t(time(nullptr) - static_cast<std::time_t>(uptime));
+}
+
+// read a small procfs file relative to the directory descriptor into the buffer
+std::string_view procfs_read(int dir_fd, const char *path, std::span<char> buffer, std::uint64_t &syscalls) {
+    const int fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+    syscalls++;
+    if (fd == -1) {
+        return {};
+    }
+    const ssize_t len = read(fd, buffer.data(), buffer.size());
+    close(fd);
+    syscalls += 2;
+    if (len <= 0) {
+        return {};
+    }
+    return {buffer.data(), static_cast<std::size_t>(len)};
+}
+
+// convert the usage fields of stat to the units of process_info and process_entry
+template <typename Info>
+void set_usage(const apptime::procfs_stat &stat, long clock_ticks, long page_size, Info &info) {
+    using namespace std::chrono;
+
+    if (clock_ticks > 0) {
+        info.cpu_time = milliseconds{(stat.utime + stat.stime) * 1000 / static_cast<unsigned long long>(clock_ticks)};
+    }
+    info.rss = stat.rss > 0 && page_size > 0 ? static_cast<std::uint64_t>(stat.rss) * static_cast<std::uint64_t>(page_size) : 0;
+}
+
+// parse a directory name as a process id
+bool procfs_pid(std::string_view name, int &pid) {
+    const auto [ptr, ec] = std::from_chars(name.data(), name.data() + name.size(), pid);
+    return ec == std::errc{} && ptr == name.data() + name.size();
+}
+
+namespace apptime {
+bool parse_procfs_stat(std::string_view content, procfs_stat &result) {
+    // the process name is enclosed in parentheses and can contain spaces and parentheses, so search for the last one
+    const std::size_t comm_end = content.rfind(')');
+    if (comm_end == std::string_view::npos || comm_end + 2 >= content.size()) {
+        return false;
+    }
+    content.remove_prefix(comm_end + 2);
+
+    // fields after the process name start from the 3rd (state), see proc(5)
+    constexpr int state_field = 3;
+    constexpr int ppid_field  = 4;
+    constexpr int utime_field = 14;
+    constexpr int stime_field = 15;
+    constexpr int start_field = 22;
+    constexpr int rss_field   = 24;
+
+    int field = state_field;
+    while (!content.empty() && field <= rss_field) {
+        const std::size_t      end   = content.find(' ');
+        const std::string_view value = content.substr(0, end);
+
+        const char *first = value.data();
+        const char *last  = value.data() + value.size();
+        switch (field) {
+        case state_field:
+            result.state = value.empty() ? 0 : value.front();
+            break;
+        case ppid_field:
+            if (std::from_chars(first, last, result.ppid).ec != std::errc{}) {
+                return false;
+            }
+            break;
+        case utime_field:
+            if (std::from_chars(first, last, result.utime).ec != std::errc{}) {
+                return false;
+            }
+            break;
+        case stime_field:
+            if (std::from_chars(first, last, result.stime).ec != std::errc{}) {
+                return false;
+            }
+            break;
+        case start_field:
+            if (std::from_chars(first, last, result.start_ticks).ec != std::errc{}) {
+                return false;
+            }
+            break;
+        case rss_field:
+            return std::from_chars(first, last, result.rss).ec == std::errc{};
+        default:
+            break;
+        }
+
+        if (end == std::string_view::npos) {
+            break;
+        }
+        content.remove_prefix(end + 1);
+        field++;
+    }
+
+    // the content can be cut after the start time
+    return field >= start_field;
+}
+
+procfs_scanner::procfs_scanner(std::filesystem::path root, std::filesystem::path cgroup_root)
+    : root_{std::move(root)},
+      cgroup_root_{std::move(cgroup_root)},
+      uid_{getuid()},
+      boot_time_{procfs_boot_time(root_)},
+      clock_ticks_{sysconf(_SC_CLK_TCK)},
+      page_size_{sysconf(_SC_PAGESIZE)} {}
+
+procfs_scanner::~procfs_scanner() {
+    if (dir_) {
+        closedir(dir_);
+    }
+}
+
+void procfs_scanner::scope(const process_scope &scope) {
+    if (scope == scope_) {
+        return;
+    }
+    scope_ = scope;
+    table_.clear();
+}
+
+std::vector<process_info> procfs_scanner::scan() {
+    std::vector<process_info> result;
+    walk([&result](const process_info &info) {
+        result.push_back(info);
+    });
+    return result;
+}
+
+std::vector<process_info> procfs_scanner::scan(std::span<const int> pids) {
+    std::vector<process_info> result;
+    walk(pids, [&result](const process_info &info) {
+        result.push_back(info);
+    });
+    return result;
+}
+
+void procfs_scanner::scan(process_buffer &result) {
+    result.clear();
+    walk([&result](const process_info &info) {
+        result.push_back(info);
+    });
+}
+
+void procfs_scanner::scan(std::span<const int> pids, process_buffer &result) {
+    result.clear();
+    walk(pids, [&result](const process_info &info) {
+        result.push_back(info);
+    });
+}
+
+template <typename Output>
+void procfs_scanner::walk(Output &&output) {
+    delta_.spawned.clear();
+    delta_.exited.clear();
+    stats_ = {};
+
+    if (dir_) {
+        rewinddir(dir_);
+    } else {
+        dir_ = opendir(root_.c_str());
+    }
+    stats_.syscalls++;
+    if (!dir_) {
+        return;
+    }
+    const int dir_fd = dirfd(dir_);
+    generation_++;
+
+    // known processes are passed right away (or after sampling), unknown ones are resolved after the walk, possibly in parallel
+    pending_.clear();
+    pending_inodes_.clear();
+    known_.clear();
+    const bool sample    = usage_;
+    const auto visit_pid = [this, sample, &output](int pid, ino_t inode) {
+        stats_.visited++;
+
+        // a known process with another inode is resolved again, its process ID may be reused
+        const auto it = table_.find(pid);
+        if (it == table_.end() || (it->second.generation != generation_ && replaced(it->second, inode))) {
+            pending_.push_back(pid);
+            pending_inodes_.push_back(inode);
+        } else if (it->second.generation != generation_) { // a process can be listed twice by cgroup.procs while it's moved
+            it->second.generation = generation_;
+            if (!it->second.in_scope) {
+                return;
+            }
+            if (sample) {
+                known_.push_back(pid);
+            } else {
+                output(it->second.info);
+            }
+        }
+    };
+
+    if (scope_.cgroup.empty()) {
+        while (const dirent *dir_entry = readdir(dir_)) {
+            int pid = 0;
+            if (dir_entry->d_type == DT_DIR && procfs_pid(dir_entry->d_name, pid)) {
+                visit_pid(pid, dir_entry->d_ino);
+            }
+        }
+    } else {
+        walk_cgroup([this, dir_fd, &visit_pid](int pid) {
+            visit_pid(pid, pid_inode(dir_fd, pid));
+        });
+    }
+
+    resolve_pending(dir_fd);
+    for (std::size_t i = 0; i < resolved_.size(); i++) {
+        entry &added = resolved_[i];
+        if (added.info.pid == -1) { // not alive
+            continue;
+        }
+        added.generation = generation_;
+        added.inode      = pending_inodes_[i];
+        identify(added.info);
+        if (const process_info *info = add(std::move(added))) {
+            output(*info);
+        }
+    }
+
+    sample_known(dir_fd, output);
+    remove_unseen();
+}
+
+template <typename Output>
+void procfs_scanner::sample_known(int dir_fd, Output &&output) {
+    if (known_.empty()) {
+        return;
+    }
+
+    read_stats(dir_fd, known_);
+    for (std::size_t i = 0; i < known_.size(); i++) {
+        entry                 &known = table_.find(known_[i])->second;
+        const std::string_view content{stat_buffer_.data() + i * stat_size, stat_lengths_[i]};
+        if (update_usage(known, content)) {
+            output(known.info);
+        } else {
+            known.generation = 0; // dropped and reported as exited by this scan
+        }
+    }
+}
+
+bool procfs_scanner::update_usage(entry &known, std::string_view stat_content) const {
+    procfs_stat stat;
+    if (!parse_procfs_stat(stat_content, stat) || stat.state == 'Z' || stat.start_ticks != known.start_ticks) {
+        return false;
+    }
+    set_usage(stat, clock_ticks_, page_size_, known.info);
+    known.info.ppid = stat.ppid; // the process is reparented when its parent exits
+    return true;
+}
+
+void procfs_scanner::read_stats(int dir_fd, std::span<const int> pids) {
+    stat_buffer_.resize(pids.size() * stat_size);
+    stat_lengths_.resize(pids.size());
+#ifdef __linux__
+    if (read_batched(dir_fd, pids)) {
+        return;
+    }
+#endif
+
+    std::array<char, 32> stat_path = {};
+    for (std::size_t i = 0; i < pids.size(); i++) {
+        std::snprintf(stat_path.data(), stat_path.size(), "%d/stat", pids[i]);
+        const std::span<char> slot{stat_buffer_.data() + i * stat_size, stat_size};
+        stat_lengths_[i] = procfs_read(dir_fd, stat_path.data(), slot, stats_.syscalls).size();
+    }
+}
+
+void procfs_scanner::sample(std::span<process_entry> entries) const {
+    sample_all(entries);
+}
+
+void procfs_scanner::sample(std::span<process_info> processes) const {
+    sample_all(processes);
+}
+
+template <typename Info>
+void procfs_scanner::sample_all(std::span<Info> processes) const {
+    const int dir_fd = open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
+        return;
+    }
+
+    std::array<char, stat_size> stat_buffer = {};
+    std::array<char, 32>        stat_path   = {};
+    std::uint64_t               syscalls    = 0;
+    for (auto &info: processes) {
+        std::snprintf(stat_path.data(), stat_path.size(), "%d/stat", info.pid);
+
+        procfs_stat stat;
+        if (parse_procfs_stat(procfs_read(dir_fd, stat_path.data(), stat_buffer, syscalls), stat) && to_time_point(stat.start_ticks) == info.start) {
+            set_usage(stat, clock_ticks_, page_size_, info);
+        }
+    }
+    close(dir_fd);
+}
+
+template <typename Visit>
+void procfs_scanner::walk_cgroup(Visit &&visit) const {
+    // every cgroup of the subtree lists its own processes only
+    const std::filesystem::path subtree = cgroup_root_ / scope_.cgroup.relative_path();
+
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it{subtree, ec}, end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_directory(ec)) {
+            continue;
+        }
+
+        std::ifstream fp{it->path() / "cgroup.procs"};
+        for (int pid = 0; fp >> pid;) {
+            visit(pid);
+        }
+    }
+
+    // processes of the subtree root
+    std::ifstream fp{subtree / "cgroup.procs"};
+    for (int pid = 0; fp >> pid;) {
+        visit(pid);
+    }
+}
+
+template <typename Output>
+void procfs_scanner::walk(std::span<const int> pids, Output &&output) {
+    delta_.spawned.clear();
+    delta_.exited.clear();
+    stats_ = {};
+
+    const int dir_fd = open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    stats_.syscalls++;
+    if (dir_fd == -1) {
+        return;
+    }
+    generation_++;
+
+    for (const int pid: pids) {
+        const auto it = table_.find(pid);
+        if (it != table_.end() && it->second.generation == generation_) { // skip duplicates
+            continue;
+        }
+        if (const process_info *info = visit(dir_fd, pid)) {
+            output(*info);
+        }
+    }
+    close(dir_fd);
+    stats_.syscalls++;
+
+    remove_unseen();
+}
+
+void procfs_scanner::resolve_pending(int dir_fd) {
+    resolved_.clear();
+    if (pending_.empty()) {
+        return;
+    }
+    stats_.resolved += pending_.size();
+    resolved_.resize(pending_.size());
+
+#ifdef __linux__
+    if (resolve_batched(dir_fd)) {
+        return;
+    }
+#endif
+
+    // every worker resolves a contiguous chunk of the pending processes, small batches aren't worth a thread
+    const std::size_t workers = std::clamp<std::size_t>(pending_.size() / min_worker_batch, 1, workers_.load());
+    const std::size_t chunk   = (pending_.size() + workers - 1) / workers;
+
+    std::vector<std::uint64_t> syscalls(workers, 0);
+    const auto                 resolve_chunk = [this, dir_fd, chunk, &syscalls](std::size_t worker) {
+        const std::size_t first = worker * chunk;
+        const std::size_t last  = std::min(first + chunk, pending_.size());
+        for (std::size_t i = first; i < last; i++) {
+            resolve(dir_fd, pending_[i], resolved_[i], syscalls[worker]);
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(workers - 1);
+    for (std::size_t worker = 1; worker < workers; worker++) {
+        threads.emplace_back(resolve_chunk, worker);
+    }
+    resolve_chunk(0);
+    threads.clear(); // join
+
+    for (const std::uint64_t count: syscalls) {
+        stats_.syscalls += count;
+    }
+}
+
+#ifdef __linux__
+bool procfs_scanner::resolve_batched(int dir_fd) {
+    stat_buffer_.resize(pending_.size() * stat_size);
+    stat_lengths_.resize(pending_.size());
+    if (!read_batched(dir_fd, pending_)) {
+        return false;
+    }
+
+    // exe can't be read by io_uring (there is no readlink operation)
+    for (std::size_t i = 0; i < pending_.size(); i++) {
+        const std::string_view content{stat_buffer_.data() + i * stat_size, stat_lengths_[i]};
+        complete(dir_fd, pending_[i], content, resolved_[i], stats_.syscalls);
+    }
+    return true;
+}
+
+bool procfs_scanner::read_batched(int dir_fd, std::span<const int> pids) {
+    if (!io_uring_ || pids.size() < min_uring_batch) {
+        return false;
+    }
+    if (!uring_) {
+        uring_ = procfs_uring::create();
+    }
+
+    // the ring isn't available or failed, don't try again
+    if (!uring_ || !uring_->read(dir_fd, pids, "stat", stat_buffer_, stat_size, stat_lengths_, stats_.syscalls)) {
+        uring_.reset();
+        io_uring_ = false;
+        return false;
+    }
+    return true;
+}
+#endif
+
+const process_info *procfs_scanner::visit(int dir_fd, int pid) {
+    stats_.visited++;
+    const ino_t inode = pid_inode(dir_fd, pid);
+    if (inode == 0) { // not alive, a known process is reported as exited by this scan
+        return nullptr;
+    }
+
+    // a known process is still alive, nothing to resolve unless its usage is sampled or its process ID may be reused
+    const auto it = table_.find(pid);
+    if (it != table_.end() && !replaced(it->second, inode)) {
+        entry &known = it->second;
+        if (!known.in_scope) {
+            known.generation = generation_;
+            return nullptr;
+        }
+        if (usage_) {
+            std::array<char, stat_size> stat_buffer = {};
+            std::array<char, 32>        stat_path   = {};
+
+            std::snprintf(stat_path.data(), stat_path.size(), "%d/stat", pid);
+            if (!update_usage(known, procfs_read(dir_fd, stat_path.data(), stat_buffer, stats_.syscalls))) {
+                return nullptr; // dropped and reported as exited by this scan
+            }
+        }
+        known.generation = generation_;
+        return &known.info;
+    }
+
+    entry added;
+    stats_.resolved++;
+    if (!resolve(dir_fd, pid, added, stats_.syscalls)) {
+        return nullptr;
+    }
+    if (added.in_scope && !scope_.cgroup.empty()) {
+        added.in_scope = in_cgroup(dir_fd, pid);
+    }
+    added.generation = generation_;
+    added.inode      = inode;
+    identify(added.info);
+    return add(std::move(added));
+}
+
+ino_t procfs_scanner::pid_inode(int dir_fd, int pid) {
+    std::array<char, 16> pid_path = {};
+    std::snprintf(pid_path.data(), pid_path.size(), "%d", pid);
+
+    struct stat dir_stat = {};
+    stats_.syscalls++;
+    return fstatat(dir_fd, pid_path.data(), &dir_stat, 0) == 0 ? dir_stat.st_ino : 0;
+}
+
+const process_info *procfs_scanner::add(entry &&added) {
+    const auto [it, inserted] = table_.try_emplace(added.info.pid);
+    entry     &known          = it->second;
+    if (!inserted) {
+        if (known.start_ticks == added.start_ticks) {
+            // the same process listed twice by this walk, or procfs gave it a new inode
+            const bool passed = known.generation == generation_;
+            known             = std::move(added);
+            return passed || !known.in_scope ? nullptr : &known.info;
+        }
+        // the process ID is reused, the known process exited
+        if (known.in_scope) {
+            delta_.exited.push_back(std::move(known.info));
+        }
+    }
+
+    known = std::move(added);
+    if (!known.in_scope) {
+        return nullptr;
+    }
+    delta_.spawned.push_back(known.info);
+    return &known.info;
+}
+
+void procfs_scanner::identify(process_info &info) {
+    if (info.exe_id != 0 || info.full_path.empty()) {
+        return;
+    }
+    const exe_cache::entry &known = exes_.insert(info.exe, info.full_path);
+    info.exe_id                   = known.id;
+    if (info.full_path != known.path) {
+        info.full_path = known.path;
+    }
+}
+
+void procfs_scanner::remove_unseen() {
+    // processes that weren't seen in this walk have exited
+    std::erase_if(table_, [this](auto &pair) {
+        if (pair.second.generation == generation_) {
+            return false;
+        }
+        if (pair.second.in_scope) {
+            delta_.exited.push_back(std::move(pair.second.info));
+        }
+        return true;
+    });
+}
+
+bool procfs_scanner::resolve(int pid, process_info &info) {
+    const int dir_fd = open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
+        return false;
+    }
+    entry         result;
+    std::uint64_t syscalls = 0;
+    const bool    alive    = resolve(dir_fd, pid, result, syscalls) && result.in_scope && (scope_.cgroup.empty() || in_cgroup(dir_fd, pid));
+    close(dir_fd);
+    if (alive) {
+        identify(result.info);
+        info = std::move(result.info);
+    }
+    return alive;
+}
+
+bool procfs_scanner::in_cgroup(int dir_fd, int pid) const {
+    std::array<char, 1024> buffer     = {};
+    std::array<char, 32>   entry_path = {};
+    std::uint64_t          syscalls   = 0;
+
+    // the cgroup v2 line is "0::<path>"
+    std::snprintf(entry_path.data(), entry_path.size(), "%d/cgroup", pid);
+    std::string_view content = procfs_read(dir_fd, entry_path.data(), buffer, syscalls);
+    const auto       start   = content.find("0::");
+    if (start == std::string_view::npos) {
+        return false;
+    }
+    content.remove_prefix(start + 3);
+    content = content.substr(0, content.find('\n'));
+
+    const std::string &subtree = scope_.cgroup.native();
+    return content.starts_with(subtree) && (content.size() == subtree.size() || content[subtree.size()] == '/' || subtree.ends_with('/'));
+}
+
+bool procfs_scanner::resolve(int dir_fd, int pid, entry &result, std::uint64_t &syscalls) const {
+    std::array<char, stat_size> stat_buffer = {};
+    std::array<char, 32>        stat_path   = {};
+
+    std::snprintf(stat_path.data(), stat_path.size(), "%d/stat", pid);
+    return complete(dir_fd, pid, procfs_read(dir_fd, stat_path.data(), stat_buffer, syscalls), result, syscalls);
+}
+
+bool procfs_scanner::complete(int dir_fd, int pid, std::string_view stat_content, entry &result, std::uint64_t &syscalls) const {
+    std::array<char, PATH_MAX> path_buffer = {};
+    std::array<char, 32>       exe_path    = {};
+
+    // a process that exited during the walk has no stat anymore
+    procfs_stat stat;
+    if (!parse_procfs_stat(stat_content, stat) || stat.state == 'Z') {
+        return false;
+    }
+
+    result.start_ticks = stat.start_ticks;
+    result.info.pid    = pid;
+    result.info.ppid   = stat.ppid;
+    result.info.start  = to_time_point(stat.start_ticks);
+    set_usage(stat, clock_ticks_, page_size_, result.info);
+
+    // the owner of the process directory is the effective user of the process
+    if (scope_.current_user) {
+        std::array<char, 16> pid_path = {};
+        std::snprintf(pid_path.data(), pid_path.size(), "%d", pid);
+
+        struct stat dir_stat = {};
+        syscalls++;
+        if (fstatat(dir_fd, pid_path.data(), &dir_stat, 0) == -1) {
+            return false;
+        }
+        result.in_scope = dir_stat.st_uid == uid_;
+        if (!result.in_scope) {
+            return true;
+        }
+    }
+
+    // kernel threads and processes of other users without permissions have no accessible exe
+    std::snprintf(exe_path.data(), exe_path.size(), "%d/exe", pid);
+    struct stat exe_stat = {};
+    syscalls++;
+    if (fstatat(dir_fd, exe_path.data(), &exe_stat, 0) == -1) {
+        return true;
+    }
+    result.info.exe = {
+        .device = static_cast<std::uint64_t>(exe_stat.st_dev),
+        .inode  = static_cast<std::uint64_t>(exe_stat.st_ino),
+        .mtime  = static_cast<std::int64_t>(exe_stat.st_mtim.tv_sec) * 1'000'000'000 + exe_stat.st_mtim.tv_nsec,
+    };
+
+    // the path of a known executable isn't read again, the identity is added to the cache after the workers have finished
+    if (const exe_cache::entry *known = exes_.find(result.info.exe)) {
+        result.info.exe_id    = known->id;
+        result.info.full_path = known->path;
+        return true;
+    }
+    const ssize_t len = readlinkat(dir_fd, exe_path.data(), path_buffer.data(), path_buffer.size() - 1);
+    syscalls++;
+    if (len > 0) {
+        result.info.full_path.assign(path_buffer.data(), static_cast<std::size_t>(len));
+    }
+    return true;
+}
+
+system_clock::time_point procfs_scanner::to_time_point(unsigned long long ticks) const {
+    if (clock_ticks_ <= 0) {
+        return boot_time_;
+    }
+    return boot_time_ + seconds{ticks / static_cast<unsigned long long>(clock_ticks_)};
+}
+} // namespace apptime
\ No newline at end of file
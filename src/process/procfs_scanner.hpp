@@ -0,0 +1,498 @@
+#ifndef APPTIME_PROCFS_SCANNER_HPP
+#define APPTIME_PROCFS_SCANNER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/types.h>
+
+#include "exe_cache.hpp"
+#include "process.hpp"
+#include "process_buffer.hpp"
+#ifdef __linux__
+#include "procfs_uring.hpp"
+#endif
+
+namespace apptime {
+/// @brief The fields of `/proc/<pid>/stat` used by the scanner.
+struct procfs_stat {
+    /// @brief The process state (R, S, Z, ...).
+    char state = 0;
+    /// @brief The parent process ID.
+    int ppid = -1;
+    /// @brief The time spent in user mode, in clock ticks.
+    unsigned long long utime = 0;
+    /// @brief The time spent in kernel mode, in clock ticks.
+    unsigned long long stime = 0;
+    /// @brief The time the process started after system boot, in clock ticks.
+    unsigned long long start_ticks = 0;
+    /// @brief The resident set size in pages (0 if the content is cut before it).
+    long long rss = 0;
+};
+
+/**
+ * @brief Parse the content of `/proc/<pid>/stat`.
+ *
+ * @param content The file content.
+ * @param result The parsed fields.
+ * @return true if the content is parsed successfully, false otherwise.
+ */
+bool parse_procfs_stat(std::string_view content, procfs_stat &result);
+
+/// @brief Processes that appeared and disappeared between two scans.
+struct procfs_delta {
+    std::vector<process_info> spawned;
+    std::vector<process_info> exited;
+};
+
+/// @brief The cost of the last scan.
+struct procfs_scan_stats {
+    /// @brief The number of process directories visited.
+    std::uint64_t visited = 0;
+    /// @brief The number of unknown processes the scanner tried to resolve.
+    std::uint64_t resolved = 0;
+    /// @brief The number of system calls made by the scanner itself (`getdents` calls made by `readdir` aren't counted).
+    std::uint64_t syscalls = 0;
+};
+
+/**
+ * @brief The class collects information about all processes from procfs in a single directory walk.
+ *
+ * The scanner keeps a table of known processes keyed by pid, so only new processes are resolved.
+ * A reused process ID is told apart by the inode of `/proc/<pid>`, procfs gives every process a new one: the directory walk
+ * gets it for free, the cgroup walk and the scan of given processes read it by one `fstatat` per process.
+ * A known process whose inode changed is resolved again and replaced if its start time differs.
+ * A process ID that disappears from one walk and shows up again in a later one is treated as a new process.
+ */
+class procfs_scanner {
+public:
+    /// @brief The minimum number of unknown processes resolved by one worker thread.
+    static constexpr std::size_t min_worker_batch = 128;
+    /// @brief The minimum number of unknown processes read through io_uring.
+    static constexpr std::size_t min_uring_batch = 8;
+    /// @brief The maximum size of `/proc/<pid>/stat` read by the scanner.
+    static constexpr std::size_t stat_size = 512;
+
+    /**
+     * @brief Construct a new scanner. The system boot time and clock ticks per second are read once here.
+     *
+     * @param root The procfs mount point, another directory with the same layout can be used for testing.
+     * @param cgroup_root The cgroup v2 mount point, it's used only by a cgroup scope.
+     */
+    explicit procfs_scanner(std::filesystem::path root = "/proc", std::filesystem::path cgroup_root = "/sys/fs/cgroup");
+    ~procfs_scanner();
+
+    procfs_scanner(const procfs_scanner &)            = delete;
+    procfs_scanner &operator=(const procfs_scanner &) = delete;
+
+    /**
+     * @brief Walk procfs and collect information about all live processes.
+     *
+     * Known processes cost nothing besides the directory walk, unless their usage is sampled (see `usage`).
+     * A new process costs one read of `stat` and one `stat` of `exe`, the path is read by `readlink` only if the executable is unknown (see `exes`).
+     * Zombies and processes that exited during the walk are skipped.
+     *
+     * @return std::vector<process_info> A vector of information about live processes.
+     */
+    std::vector<process_info> scan();
+
+    /**
+     * @brief Collect information about the given processes only.
+     *
+     * Known processes that aren't in the list are dropped from the table and reported as exited.
+     *
+     * @param pids The process IDs.
+     * @return std::vector<process_info> A vector of information about live processes.
+     */
+    std::vector<process_info> scan(std::span<const int> pids);
+
+    /**
+     * @brief Walk procfs and fill a caller-owned buffer with information about all live processes.
+     *
+     * Known processes are copied from the table, so a reused buffer doesn't allocate memory unless new processes are found.
+     *
+     * @param result The buffer, it's cleared before filling.
+     */
+    void scan(process_buffer &result);
+
+    /**
+     * @brief Fill a caller-owned buffer with information about the given processes only.
+     *
+     * @param pids The process IDs.
+     * @param result The buffer, it's cleared before filling.
+     */
+    void scan(std::span<const int> pids, process_buffer &result);
+
+    /**
+     * @brief Get processes that were spawned or exited since the previous scan.
+     *
+     * @return const procfs_delta& The changes found by the last scan.
+     */
+    const procfs_delta &delta() const { return delta_; }
+
+    /**
+     * @brief Get the cost of the last scan.
+     *
+     * @return const procfs_scan_stats& The counters of the last scan.
+     */
+    const procfs_scan_stats &stats() const { return stats_; }
+
+    /**
+     * @brief Set the number of threads that resolve new processes during a walk of procfs.
+     *
+     * The walk itself is serial, only unknown processes are split between the threads.
+     * A thread is started only for at least `min_worker_batch` unknown processes, so scans of a stable system stay serial.
+     *
+     * @param count The number of threads including the calling one (1 by default), it can be changed while a scan is running.
+     */
+    void workers(unsigned count) { workers_ = std::max(count, 1U); }
+
+    /**
+     * @brief Get the number of threads that resolve new processes during a walk of procfs.
+     *
+     * @return unsigned The number of threads including the calling one.
+     */
+    unsigned workers() const { return workers_; }
+
+    /**
+     * @brief Limit the processes collected by the scanner.
+     *
+     * For the current user, the owner of every new process is checked once and processes of other users are remembered, so they aren't resolved again.
+     * For a cgroup, processes are listed from `cgroup.procs` of the subtree instead of walking procfs.
+     * Changing the scope drops the table of known processes.
+     *
+     * @param scope The scope.
+     */
+    void scope(const process_scope &scope);
+
+    /**
+     * @brief Get the scope of the scanner.
+     *
+     * @return const process_scope& The scope.
+     */
+    const process_scope &scope() const { return scope_; }
+
+    /**
+     * @brief Enable or disable reading `stat` of unknown processes through io_uring (Linux only, enabled by default).
+     *
+     * If the ring can't be set up or fails, the scanner falls back to the system calls per process and disables io_uring.
+     * The batched path doesn't use the worker threads.
+     *
+     * @param enable true to enable io_uring, false to disable it.
+     */
+    void io_uring(bool enable) { io_uring_ = enable; }
+
+    /**
+     * @brief Check if io_uring is enabled and hasn't failed.
+     *
+     * @return true if io_uring is enabled, false otherwise.
+     */
+    bool io_uring() const { return io_uring_; }
+
+    /**
+     * @brief Enable or disable sampling of CPU time and resident set size of known processes (disabled by default).
+     *
+     * New processes always get their usage from the `stat` read that resolves them.
+     * With sampling, `stat` of known processes is read again by every scan, batched like the reads of new processes,
+     * and a process whose `stat` can't be read anymore is reported as exited by the same scan.
+     *
+     * @param enable true to enable sampling, false to disable it.
+     */
+    void usage(bool enable) { usage_ = enable; }
+
+    /**
+     * @brief Check if known processes are sampled.
+     *
+     * @return true if sampling is enabled, false otherwise.
+     */
+    bool usage() const { return usage_; }
+
+    /**
+     * @brief Sample CPU time and resident set size of processes collected by someone else, e.g. from process events.
+     *
+     * The method doesn't touch the table, so it can be called concurrently with scans.
+     * Processes that exited or whose process ID is reused are left as is.
+     *
+     * @param entries The processes.
+     */
+    void sample(std::span<process_entry> entries) const;
+
+    /**
+     * @brief Sample CPU time and resident set size of processes collected by someone else, e.g. from process events.
+     *
+     * @param processes The processes.
+     */
+    void sample(std::span<process_info> processes) const;
+
+    /**
+     * @brief Get the executables seen by the scanner, the processes get their IDs and canonical paths from it.
+     *
+     * @return const exe_cache& The executables.
+     */
+    const exe_cache &exes() const { return exes_; }
+
+    /**
+     * @brief Get the procfs mount point.
+     *
+     * @return const std::filesystem::path& The procfs mount point.
+     */
+    const std::filesystem::path &root() const { return root_; }
+
+    /**
+     * @brief Read information about a single process.
+     *
+     * @param pid The process ID.
+     * @param info The information about the process.
+     * @return true if the process is alive, false otherwise.
+     */
+    bool resolve(int pid, process_info &info);
+
+    /**
+     * @brief Convert the start time of a process in clock ticks to a time point.
+     *
+     * @param ticks The start time in clock ticks after system boot.
+     * @return std::chrono::system_clock::time_point The start time of the process.
+     */
+    std::chrono::system_clock::time_point to_time_point(unsigned long long ticks) const;
+
+private:
+    /// @brief A known process.
+    struct entry {
+        /// @brief The start time of the process in clock ticks, it tells apart reused process IDs.
+        unsigned long long start_ticks = 0;
+        /// @brief The inode of the process directory (0 if unknown), a changed inode is checked by the start time.
+        ino_t inode = 0;
+        /// @brief The number of the last scan that saw the process.
+        std::uint64_t generation = 0;
+        /// @brief false if the process is out of the scope, it's kept in the table only to not be resolved again.
+        bool in_scope = true;
+        /// @brief The resolved information.
+        process_info info;
+    };
+
+    /**
+     * @brief Read `stat` and `exe` of a process relative to the procfs directory.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param pid The process ID.
+     * @param result The resolved process.
+     * @param syscalls The counter of system calls.
+     * @return true if the process is alive, false otherwise.
+     */
+    bool resolve(int dir_fd, int pid, entry &result, std::uint64_t &syscalls) const;
+
+    /**
+     * @brief Parse the content of `stat` and identify `exe` of a process relative to the procfs directory.
+     *
+     * The path of a known executable is taken from `exes_`, so the method only reads the cache and can be called by the worker threads.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param pid The process ID.
+     * @param stat_content The content of `stat`, empty if it can't be read.
+     * @param result The resolved process.
+     * @param syscalls The counter of system calls.
+     * @return true if the process is alive, false otherwise.
+     */
+    bool complete(int dir_fd, int pid, std::string_view stat_content, entry &result, std::uint64_t &syscalls) const;
+
+    /**
+     * @brief Walk procfs and pass every live process to the output.
+     *
+     * @param output The function called with `const process_info &` of every live process.
+     */
+    template <typename Output>
+    void walk(Output &&output);
+
+    /**
+     * @brief Pass the process IDs listed by `cgroup.procs` of the scope subtree to the function.
+     *
+     * @param visit The function called with every process ID.
+     */
+    template <typename Visit>
+    void walk_cgroup(Visit &&visit) const;
+
+    /**
+     * @brief Pass the given live processes to the output in the order of the list, duplicates are skipped.
+     *
+     * @param pids The process IDs.
+     * @param output The function called with `const process_info &` of every live process.
+     */
+    template <typename Output>
+    void walk(std::span<const int> pids, Output &&output);
+
+    /**
+     * @brief Mark a process as seen by the current scan, resolving it if it's unknown.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param pid The process ID.
+     * @return const process_info* The information about the process, or nullptr if it isn't alive.
+     */
+    const process_info *visit(int dir_fd, int pid);
+
+    /**
+     * @brief Read the inode of a process directory.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param pid The process ID.
+     * @return ino_t The inode, or 0 if the process doesn't exist.
+     */
+    ino_t pid_inode(int dir_fd, int pid);
+
+    /**
+     * @brief Check if the process directory of a known process has another inode, so the process ID may be reused.
+     *
+     * @param known The known process.
+     * @param inode The inode seen by the current walk (0 if unknown).
+     * @return true if the process has to be resolved again, false otherwise.
+     */
+    static bool replaced(const entry &known, ino_t inode) { return inode != 0 && known.inode != 0 && inode != known.inode; }
+
+    /**
+     * @brief Add a resolved process to the table, it replaces a known process with the same ID.
+     *
+     * A known process with the same start time only got a new inode, it isn't reported as spawned.
+     * Otherwise the process ID is reused: the known process is reported as exited and the resolved one as spawned.
+     *
+     * @param added The resolved process.
+     * @return const process_info* The process to pass to the output, or nullptr if it's out of the scope or it's already passed by this walk.
+     */
+    const process_info *add(entry &&added);
+
+    /**
+     * @brief Read `stat` of known processes of the current walk again, update their usage and pass live ones to the output.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param output The function called with `const process_info &` of every live process.
+     */
+    template <typename Output>
+    void sample_known(int dir_fd, Output &&output);
+
+    /**
+     * @brief Sample the given processes (see `sample`).
+     *
+     * @param processes The processes.
+     */
+    template <typename Info>
+    void sample_all(std::span<Info> processes) const;
+
+    /**
+     * @brief Update the usage of a known process from the content of its `stat`.
+     *
+     * @param known The known process.
+     * @param stat_content The content of `stat`, empty if it can't be read.
+     * @return true if the process is alive, false if it exited or its process ID is reused.
+     */
+    bool update_usage(entry &known, std::string_view stat_content) const;
+
+    /**
+     * @brief Read `stat` of the processes into `stat_buffer_`, through io_uring when possible.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param pids The process IDs.
+     */
+    void read_stats(int dir_fd, std::span<const int> pids);
+
+    /**
+     * @brief Resolve the pending processes of the current walk into `resolved_`, dead processes are left with pid -1.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     */
+    void resolve_pending(int dir_fd);
+
+#ifdef __linux__
+    /**
+     * @brief Resolve the pending processes reading their `stat` through io_uring.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @return true if the processes are resolved, false if io_uring isn't used.
+     */
+    bool resolve_batched(int dir_fd);
+
+    /**
+     * @brief Read `stat` of the processes into `stat_buffer_` through io_uring.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param pids The process IDs.
+     * @return true if the files are read, false if io_uring isn't used.
+     */
+    bool read_batched(int dir_fd, std::span<const int> pids);
+#endif
+
+    /**
+     * @brief Check if a process belongs to the cgroup subtree of the scope by reading `<pid>/cgroup`.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param pid The process ID.
+     * @return true if the process is in the subtree, false otherwise.
+     */
+    bool in_cgroup(int dir_fd, int pid) const;
+
+    /**
+     * @brief Give a resolved process the ID and the canonical path of its executable, the executable is added if it's unknown.
+     *
+     * @param info The information about the process.
+     */
+    void identify(process_info &info);
+
+    /// @brief Drop processes that weren't seen by the current scan.
+    void remove_unseen();
+
+    /// @brief Known processes by process ID.
+    std::unordered_map<int, entry> table_;
+    /// @brief The number of the current scan.
+    std::uint64_t generation_ = 0;
+    /// @brief The changes found by the last scan.
+    procfs_delta delta_;
+    /// @brief The cost of the last scan.
+    procfs_scan_stats stats_;
+    /// @brief The number of threads that resolve new processes.
+    std::atomic_uint workers_ = 1;
+    /// @brief Unknown processes found by the current walk, the inodes of their directories and their resolved entries, reused between walks.
+    std::vector<int>   pending_;
+    std::vector<ino_t> pending_inodes_;
+    std::vector<entry> resolved_;
+    /// @brief Known processes found by the current walk that are sampled again, reused between walks.
+    std::vector<int> known_;
+    /// @brief Sample known processes.
+    std::atomic_bool usage_ = false;
+    /// @brief The executables of resolved processes, it isn't dropped with the table.
+    exe_cache exes_;
+
+    /// @brief Read `stat` through io_uring.
+    std::atomic_bool io_uring_ = true;
+#ifdef __linux__
+    /// @brief The ring (nullptr until the first batch).
+    std::unique_ptr<procfs_uring> uring_;
+#endif
+    /// @brief The content of `stat` of a batch of processes, `stat_size` bytes per process.
+    std::vector<char>        stat_buffer_;
+    std::vector<std::size_t> stat_lengths_;
+
+    /// @brief The procfs mount point.
+    std::filesystem::path root_;
+    /// @brief The cgroup v2 mount point.
+    std::filesystem::path cgroup_root_;
+    /// @brief The processes collected by the scanner.
+    process_scope scope_;
+    /// @brief The user ID of the application.
+    uid_t uid_;
+    /// @brief The procfs directory stream, it's kept open and rewound by every walk, so the walk doesn't allocate its buffer.
+    DIR *dir_ = nullptr;
+    /// @brief The system boot time.
+    std::chrono::system_clock::time_point boot_time_;
+    /// @brief The number of clock ticks per second.
+    long clock_ticks_;
+    /// @brief The size of a memory page in bytes.
+    long page_size_;
+};
+} // namespace apptime
+
+#endif // APPTIME_PROCFS_SCANNER_HPP
\ No newline at end of file
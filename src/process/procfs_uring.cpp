@@ -0,0 +1,242 @@
+#include "procfs_uring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// operations of a process chain, stored in the low bits of user_data
+enum chain_op : std::uint64_t { chain_open = 0, chain_read = 1, chain_close = 2 };
+
+constexpr unsigned chain_length = 3;
+
+// glibc has no wrappers for io_uring
+int uring_setup(unsigned entries, io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int uring_register(int fd, unsigned opcode, const void *arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// check that the kernel supports the operations used by the chains
+bool uring_supported(int fd) {
+    constexpr std::size_t ops_count = IORING_OP_LAST;
+
+    std::vector<char> buffer(sizeof(io_uring_probe) + ops_count * sizeof(io_uring_probe_op));
+    auto             *probe = reinterpret_cast<io_uring_probe *>(buffer.data()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (uring_register(fd, IORING_REGISTER_PROBE, probe, ops_count) == -1) {
+        return false;
+    }
+
+    for (const int op: {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) { // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+T *at_offset(void *base, std::uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+namespace apptime {
+std::unique_ptr<procfs_uring> procfs_uring::create() {
+    constexpr unsigned entries = batch_size * chain_length;
+
+    io_uring_params params = {};
+    const int       fd     = uring_setup(entries, &params);
+    if (fd == -1) {
+        return nullptr;
+    }
+
+    std::unique_ptr<procfs_uring> result{new procfs_uring{fd}};
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !uring_supported(fd)) {
+        return nullptr;
+    }
+
+    // map the submission and completion rings (one mapping since 5.4) and the submission entries
+    const std::size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    const std::size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const std::size_t size    = std::max(sq_size, cq_size);
+
+    void *ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED) {
+        return nullptr;
+    }
+    result->ring_ = {.data = ring, .size = size};
+
+    const std::size_t sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void             *sqes      = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return nullptr;
+    }
+    result->sqes_ = {.data = sqes, .size = sqes_size};
+
+    result->sq_tail_  = at_offset<unsigned>(ring, params.sq_off.tail);
+    result->sq_mask_  = at_offset<unsigned>(ring, params.sq_off.ring_mask);
+    result->sq_array_ = at_offset<unsigned>(ring, params.sq_off.array);
+    result->cq_head_  = at_offset<unsigned>(ring, params.cq_off.head);
+    result->cq_tail_  = at_offset<unsigned>(ring, params.cq_off.tail);
+    result->cq_mask_  = at_offset<unsigned>(ring, params.cq_off.ring_mask);
+    result->cqes_     = at_offset<io_uring_cqe>(ring, params.cq_off.cqes);
+
+    if (!result->init(params.sq_entries) || !result->self_test()) {
+        return nullptr;
+    }
+    return result;
+}
+
+procfs_uring::procfs_uring(int fd) : fd_{fd} {}
+
+procfs_uring::~procfs_uring() {
+    if (sqes_.data) {
+        munmap(sqes_.data, sqes_.size);
+    }
+    if (ring_.data) {
+        munmap(ring_.data, ring_.size);
+    }
+    close(fd_);
+}
+
+bool procfs_uring::init(unsigned entries) {
+    // the entries of the submission array never change, entry i is always at index i
+    for (unsigned i = 0; i < entries; i++) {
+        sq_array_[i] = i;
+    }
+
+    // empty slots for the direct descriptors, one per process of a batch
+    const std::vector<int> slots(batch_size, -1);
+    if (uring_register(fd_, IORING_REGISTER_FILES, slots.data(), batch_size) == -1) {
+        return false;
+    }
+
+    paths_.resize(batch_size);
+    opens_.resize(batch_size);
+    results_.resize(batch_size);
+    return true;
+}
+
+bool procfs_uring::self_test() {
+    const int dir_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
+        return false;
+    }
+
+    std::array<char, 1024>     buffer   = {};
+    std::array<std::size_t, 1> lengths  = {};
+    const std::array           pids     = {static_cast<int>(getpid())};
+    std::uint64_t              syscalls = 0;
+    const bool                 result   = read(dir_fd, pids, "stat", buffer, buffer.size(), lengths, syscalls) && opens_[0] == 0 && lengths[0] > 0;
+    close(dir_fd);
+    return result;
+}
+
+io_uring_sqe *procfs_uring::sqe(unsigned index) {
+    auto *result = static_cast<io_uring_sqe *>(sqes_.data) + index;
+    std::memset(result, 0, sizeof(io_uring_sqe));
+    return result;
+}
+
+bool procfs_uring::read(int dir_fd, std::span<const int> pids, const char *name, std::span<char> buffer, std::size_t slot_size,
+                        std::span<std::size_t> lengths, std::uint64_t &syscalls) {
+    for (std::size_t first = 0; first < pids.size(); first += batch_size) {
+        const auto count = static_cast<unsigned>(std::min<std::size_t>(batch_size, pids.size() - first));
+
+        const unsigned tail = std::atomic_ref{*sq_tail_}.load(std::memory_order_relaxed);
+        for (unsigned i = 0; i < count; i++) {
+            std::snprintf(paths_[i].data(), paths_[i].size(), "%d/%s", pids[first + i], name);
+
+            // a failed open cancels the read and the close, a failed read doesn't cancel the close (hard link)
+            io_uring_sqe *open = sqe((tail + i * chain_length) & *sq_mask_);
+            open->opcode       = IORING_OP_OPENAT;
+            open->fd           = dir_fd;
+            open->addr         = std::bit_cast<std::uint64_t>(paths_[i].data());
+            open->open_flags   = O_RDONLY; // O_CLOEXEC is invalid for direct descriptors
+            open->file_index   = i + 1;    // 1-based, 0 means a normal descriptor
+            open->flags        = IOSQE_IO_LINK;
+            open->user_data    = (static_cast<std::uint64_t>(i) << 2) | chain_open;
+
+            io_uring_sqe *read = sqe((tail + i * chain_length + 1) & *sq_mask_);
+            read->opcode       = IORING_OP_READ;
+            read->fd           = static_cast<int>(i);
+            read->addr         = std::bit_cast<std::uint64_t>(buffer.data() + (first + i) * slot_size);
+            read->len          = static_cast<std::uint32_t>(slot_size);
+            read->flags        = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            read->user_data    = (static_cast<std::uint64_t>(i) << 2) | chain_read;
+
+            io_uring_sqe *close = sqe((tail + i * chain_length + 2) & *sq_mask_);
+            close->opcode       = IORING_OP_CLOSE;
+            close->file_index   = i + 1;
+            close->user_data    = (static_cast<std::uint64_t>(i) << 2) | chain_close;
+        }
+        std::atomic_ref{*sq_tail_}.store(tail + count * chain_length, std::memory_order_release);
+
+        if (!submit_and_wait(count * chain_length, syscalls)) {
+            return false;
+        }
+
+        // a kernel without direct descriptors ignores file_index and returns a normal descriptor, or rejects the slot
+        bool supported = true;
+        for (unsigned i = 0; i < count; i++) {
+            if (opens_[i] > 0) {
+                ::close(opens_[i]);
+                syscalls++;
+            }
+            supported          = supported && opens_[i] <= 0 && opens_[i] != -EINVAL && opens_[i] != -EBADF;
+            lengths[first + i] = results_[i] > 0 ? static_cast<std::size_t>(results_[i]) : 0;
+        }
+        if (!supported) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool procfs_uring::submit_and_wait(unsigned count, std::uint64_t &syscalls) {
+    unsigned submitted = 0;
+    unsigned completed = 0;
+    std::fill(opens_.begin(), opens_.end(), 0);
+    std::fill(results_.begin(), results_.end(), 0);
+
+    while (completed < count) {
+        const int ret = uring_enter(fd_, count - submitted, count - completed, IORING_ENTER_GETEVENTS);
+        syscalls++;
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        submitted += static_cast<unsigned>(ret);
+
+        // reap the completions
+        unsigned       head = std::atomic_ref{*cq_head_}.load(std::memory_order_relaxed);
+        const unsigned tail = std::atomic_ref{*cq_tail_}.load(std::memory_order_acquire);
+        for (; head != tail; head++, completed++) {
+            const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+            if ((cqe.user_data & 3) == chain_open) {
+                opens_[cqe.user_data >> 2] = cqe.res;
+            } else if ((cqe.user_data & 3) == chain_read) {
+                results_[cqe.user_data >> 2] = cqe.res;
+            }
+        }
+        std::atomic_ref{*cq_head_}.store(head, std::memory_order_release);
+    }
+    return true;
+}
+} // namespace apptime
\ No newline at end of file
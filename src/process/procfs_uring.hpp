@@ -0,0 +1,114 @@
+#ifndef APPTIME_PROCFS_URING_HPP
+#define APPTIME_PROCFS_URING_HPP
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace apptime {
+/**
+ * @brief The class reads small files of many processes from procfs through io_uring.
+ *
+ * For every process, openat into a registered file slot, read and close are submitted as one linked chain,
+ * so a batch of processes costs a single `io_uring_enter` instead of three system calls per process.
+ * The ring is set up with raw system calls, so no library is needed. Linux 5.15+ is required for direct descriptors.
+ */
+class procfs_uring {
+public:
+    /// @brief The number of processes submitted at once.
+    static constexpr unsigned batch_size = 128;
+
+    /**
+     * @brief Set up a ring.
+     *
+     * @return std::unique_ptr<procfs_uring> The ring, or nullptr if io_uring, one of the needed operations or direct descriptors aren't available.
+     */
+    static std::unique_ptr<procfs_uring> create();
+
+    ~procfs_uring();
+
+    procfs_uring(const procfs_uring &)            = delete;
+    procfs_uring &operator=(const procfs_uring &) = delete;
+
+    /**
+     * @brief Read `<pid>/<name>` of every process relative to the procfs directory.
+     *
+     * @param dir_fd The procfs directory descriptor.
+     * @param pids The process IDs.
+     * @param name The file name, e.g. "stat".
+     * @param buffer The buffer split into slots of `slot_size` bytes, one slot per process.
+     * @param slot_size The size of a slot.
+     * @param lengths The number of bytes read per process, 0 if the process has exited.
+     * @param syscalls The counter of system calls.
+     * @return true if the files are read, false if the ring failed or an open was rejected (e.g. direct descriptors aren't supported)
+     * and the caller has to read them itself.
+     */
+    bool read(int dir_fd, std::span<const int> pids, const char *name, std::span<char> buffer, std::size_t slot_size, std::span<std::size_t> lengths,
+              std::uint64_t &syscalls);
+
+private:
+    /// @brief A mapped region of the ring.
+    struct mapping {
+        void       *data = nullptr;
+        std::size_t size = 0;
+    };
+
+    explicit procfs_uring(int fd);
+
+    /**
+     * @brief Map the rings and register the file slots.
+     *
+     * @param entries The number of submission queue entries.
+     * @return true if the ring is ready, false otherwise.
+     */
+    bool init(unsigned entries);
+
+    /**
+     * @brief Read `stat` of the current process through one chain.
+     *
+     * Kernels before 5.15 accept the chains but don't open direct descriptors, so every chain would fail.
+     *
+     * @return true if the open filled a direct descriptor and the read returned data, false otherwise.
+     */
+    bool self_test();
+
+    /**
+     * @brief Submit a batch and wait for all of its completions.
+     *
+     * @param count The number of submission queue entries filled.
+     * @param syscalls The counter of system calls.
+     * @return true if all completions are received, false otherwise.
+     */
+    bool submit_and_wait(unsigned count, std::uint64_t &syscalls);
+
+    io_uring_sqe *sqe(unsigned index);
+
+    int fd_;
+
+    /// @brief The rings (one mapping for the submission and completion rings) and the submission entries.
+    mapping ring_, sqes_;
+
+    // pointers into the mapped rings
+    unsigned     *sq_tail_  = nullptr;
+    unsigned     *sq_mask_  = nullptr;
+    unsigned     *sq_array_ = nullptr;
+    unsigned     *cq_head_  = nullptr;
+    unsigned     *cq_tail_  = nullptr;
+    unsigned     *cq_mask_  = nullptr;
+    io_uring_cqe *cqes_     = nullptr;
+
+    /// @brief The relative paths of the current batch, they must live until the batch is completed.
+    std::vector<std::array<char, 32>> paths_;
+    /// @brief The results of open operations of the current batch.
+    std::vector<int> opens_;
+    /// @brief The results of read operations of the current batch.
+    std::vector<int> results_;
+};
+} // namespace apptime
+
+#endif // APPTIME_PROCFS_URING_HPP
\ No newline at end of file
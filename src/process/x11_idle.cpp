@@ -0,0 +1,146 @@
+#include "x11_idle.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <xcb/screensaver.h>
+#include <xcb/xcb.h>
+
+namespace apptime {
+std::unique_ptr<x11_idle> x11_idle::connect(const char *display) {
+    int               screen_number = 0;
+    xcb_connection_t *connection    = xcb_connect(display, &screen_number);
+    if (xcb_connection_has_error(connection)) {
+        xcb_disconnect(connection);
+        return nullptr;
+    }
+
+    // find the root window of the default screen
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator(xcb_get_setup(connection));
+    for (int i = 0; i < screen_number && screens.rem; i++) {
+        xcb_screen_next(&screens);
+    }
+    const xcb_query_extension_reply_t *extension = xcb_get_extension_data(connection, &xcb_screensaver_id);
+    if (!screens.rem || !extension || !extension->present) {
+        xcb_disconnect(connection);
+        return nullptr;
+    }
+
+    // the version must be negotiated before other requests of the extension
+    free(xcb_screensaver_query_version_reply(connection, xcb_screensaver_query_version(connection, 1, 1), nullptr)); // NOLINT(cppcoreguidelines-no-malloc)
+
+    // the constructor is private, so std::make_unique can't be used
+    return std::unique_ptr<x11_idle>{new x11_idle{connection, screens.data->root, extension->first_event}};
+}
+
+x11_idle::x11_idle(xcb_connection_t *connection, std::uint32_t root, std::uint8_t first_event)
+    : connection_{connection},
+      root_{root},
+      first_event_{first_event},
+      wakeup_{eventfd(0, EFD_CLOEXEC)},
+      running_{false} {
+    // receive changes of the screen saver state
+    xcb_screensaver_select_input(connection_, root_, XCB_SCREENSAVER_EVENT_NOTIFY_MASK);
+    xcb_flush(connection_);
+
+    update();
+    if (wakeup_ == -1) {
+        return;
+    }
+    running_ = true;
+    thread_  = std::thread{&x11_idle::event_thread, this};
+}
+
+x11_idle::~x11_idle() {
+    running_ = false;
+    if (wakeup_ != -1) {
+        eventfd_write(wakeup_, 1);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (wakeup_ != -1) {
+        close(wakeup_);
+    }
+    xcb_disconnect(connection_);
+}
+
+void x11_idle::on_idle_change(idle_callback callback) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    callback_ = std::move(callback);
+    if (idle_ && callback_) {
+        const idle_callback copy  = callback_;
+        const time_point    since = since_;
+        lock.unlock();
+        copy(true, since);
+    }
+}
+
+void x11_idle::event_thread() {
+    std::array<pollfd, 2> fds = {{
+        {.fd = xcb_get_file_descriptor(connection_), .events = POLLIN, .revents = 0},
+        {.fd = wakeup_, .events = POLLIN, .revents = 0},
+    }};
+
+    while (running_ && !xcb_connection_has_error(connection_)) {
+        if (poll(fds.data(), fds.size(), -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) { // stopped
+            break;
+        }
+
+        // read all queued events, so poll doesn't miss those buffered by xcb
+        bool changed = false;
+        while (xcb_generic_event_t *event = xcb_poll_for_event(connection_)) {
+            if ((event->response_type & ~0x80) == first_event_ + XCB_SCREENSAVER_NOTIFY) {
+                changed = update() || changed;
+            }
+            free(event); // NOLINT(cppcoreguidelines-no-malloc)
+        }
+
+        if (changed) {
+            idle_callback callback;
+            bool          idle = false;
+            time_point    since;
+            {
+                const std::lock_guard<std::mutex> lock{mutex_};
+                callback = callback_;
+                idle     = idle_;
+                since    = since_;
+            }
+            if (callback) {
+                callback(idle, since);
+            }
+        }
+    }
+}
+
+bool x11_idle::update() {
+    xcb_screensaver_query_info_reply_t *reply = xcb_screensaver_query_info_reply(connection_, xcb_screensaver_query_info(connection_, root_), nullptr);
+    if (!reply) {
+        return false;
+    }
+    const auto now  = std::chrono::system_clock::now();
+    const bool idle = reply->state == XCB_SCREENSAVER_STATE_ON || reply->state == XCB_SCREENSAVER_STATE_CYCLE;
+
+    // the user left at the last input, not when the screen saver started
+    const time_point since = idle ? now - std::chrono::milliseconds{reply->ms_since_user_input} : now;
+    free(reply); // NOLINT(cppcoreguidelines-no-malloc)
+
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (idle == idle_) {
+        return false;
+    }
+    idle_  = idle;
+    since_ = since;
+    return true;
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef APPTIME_X11_IDLE_HPP
+#define APPTIME_X11_IDLE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "idle_detector.hpp"
+
+struct xcb_connection_t;
+
+namespace apptime {
+/**
+ * @brief The class detects idle by the MIT-SCREEN-SAVER extension of an X11 server.
+ *
+ * The user is away while the screen saver of the server is on, so the timeout is the one of the desktop (e.g. `xset s`).
+ * `ScreenSaverNotify` events are received by a separate thread, which sleeps in `poll` between them.
+ */
+class x11_idle : public idle_detector {
+public:
+    /**
+     * @brief Connect to an X11 server.
+     *
+     * @param display The display name (nullptr to use the DISPLAY environment variable).
+     * @return std::unique_ptr<x11_idle> The detector, or nullptr if the connection fails or the server doesn't have the extension.
+     */
+    static std::unique_ptr<x11_idle> connect(const char *display = nullptr);
+
+    ~x11_idle() override;
+
+    x11_idle(const x11_idle &)            = delete;
+    x11_idle &operator=(const x11_idle &) = delete;
+
+    void on_idle_change(idle_callback callback) override;
+
+private:
+    x11_idle(xcb_connection_t *connection, std::uint32_t root, std::uint8_t first_event);
+
+    /// @brief Receive X11 events until the detector is destroyed.
+    void event_thread();
+
+    /**
+     * @brief Read the state of the screen saver and update the idle state.
+     *
+     * @return true if the idle state changed, false otherwise.
+     */
+    bool update();
+
+    xcb_connection_t *connection_;
+    std::uint32_t     root_;
+    /// @brief The first event code of the extension.
+    std::uint8_t first_event_;
+
+    /// @brief The eventfd used to wake up the event thread.
+    int wakeup_ = -1;
+
+    std::mutex    mutex_;
+    bool          idle_ = false;
+    time_point    since_;
+    idle_callback callback_;
+
+    std::thread      thread_;
+    std::atomic_bool running_;
+};
+} // namespace apptime
+
+#endif // APPTIME_X11_IDLE_HPP
\ No newline at end of file
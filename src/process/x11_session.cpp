@@ -0,0 +1,359 @@
+#include "x11_session.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstdlib>
+#include <string_view>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <xcb/xcb.h>
+
+// intern an atom that must already exist (e.g. set by the window manager)
+xcb_intern_atom_cookie_t intern_atom(xcb_connection_t *connection, std::string_view name) {
+    return xcb_intern_atom(connection, 1, static_cast<std::uint16_t>(name.size()), name.data());
+}
+
+std::uint32_t intern_atom_reply(xcb_connection_t *connection, xcb_intern_atom_cookie_t cookie) {
+    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(connection, cookie, nullptr);
+    if (!reply) {
+        return XCB_ATOM_NONE;
+    }
+    const std::uint32_t result = reply->atom;
+    free(reply); // NOLINT(cppcoreguidelines-no-malloc)
+    return result;
+}
+
+// the last version of window names, it's shared by all sessions so versions are never repeated
+std::atomic<std::uint64_t> window_name_version = 0;
+
+namespace apptime {
+std::unique_ptr<x11_session> x11_session::connect(const char *display) {
+    int               screen_number = 0;
+    xcb_connection_t *connection    = xcb_connect(display, &screen_number);
+    if (xcb_connection_has_error(connection)) {
+        xcb_disconnect(connection);
+        return nullptr;
+    }
+
+    // find the root window of the default screen
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator(xcb_get_setup(connection));
+    for (int i = 0; i < screen_number && screens.rem; i++) {
+        xcb_screen_next(&screens);
+    }
+    if (!screens.rem) {
+        xcb_disconnect(connection);
+        return nullptr;
+    }
+    const std::uint32_t root = screens.data->root;
+
+    // send all requests before waiting for replies
+    const auto active_window_cookie = intern_atom(connection, "_NET_ACTIVE_WINDOW");
+    const auto client_list_cookie   = intern_atom(connection, "_NET_CLIENT_LIST");
+    const auto wm_pid_cookie        = intern_atom(connection, "_NET_WM_PID");
+    const auto wm_name_cookie       = intern_atom(connection, "_NET_WM_NAME");
+    const auto wm_state_cookie      = intern_atom(connection, "_NET_WM_STATE");
+    const auto state_hidden_cookie  = intern_atom(connection, "_NET_WM_STATE_HIDDEN");
+    const auto utf8_string_cookie   = intern_atom(connection, "UTF8_STRING");
+
+    atoms names;
+    names.net_active_window   = intern_atom_reply(connection, active_window_cookie);
+    names.net_client_list     = intern_atom_reply(connection, client_list_cookie);
+    names.net_wm_pid          = intern_atom_reply(connection, wm_pid_cookie);
+    names.net_wm_name         = intern_atom_reply(connection, wm_name_cookie);
+    names.net_wm_state        = intern_atom_reply(connection, wm_state_cookie);
+    names.net_wm_state_hidden = intern_atom_reply(connection, state_hidden_cookie);
+    names.utf8_string         = intern_atom_reply(connection, utf8_string_cookie);
+    if (names.net_active_window == XCB_ATOM_NONE || names.net_wm_pid == XCB_ATOM_NONE) {
+        xcb_disconnect(connection);
+        return nullptr;
+    }
+
+    // the constructor is private, so std::make_unique can't be used
+    return std::unique_ptr<x11_session>{new x11_session{connection, root, names}};
+}
+
+x11_session::x11_session(xcb_connection_t *connection, std::uint32_t root, const atoms &atoms)
+    : connection_{connection},
+      root_{root},
+      atoms_{atoms},
+      wakeup_{eventfd(0, EFD_CLOEXEC)},
+      running_{false} {
+    // receive property changes of the root window
+    const std::uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+    xcb_change_window_attributes(connection_, root_, XCB_CW_EVENT_MASK, &mask);
+    xcb_flush(connection_);
+
+    update_focus(std::chrono::system_clock::now());
+    if (wakeup_ == -1) {
+        return;
+    }
+    running_ = true;
+    thread_  = std::thread{&x11_session::event_thread, this};
+}
+
+x11_session::~x11_session() {
+    running_ = false;
+    if (wakeup_ != -1) {
+        eventfd_write(wakeup_, 1);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (wakeup_ != -1) {
+        close(wakeup_);
+    }
+    xcb_disconnect(connection_);
+}
+
+x11_session::focus x11_session::focused() const {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    return focus_;
+}
+
+std::vector<x11_session::window> x11_session::windows(bool only_visible) const {
+    // the managed windows
+    constexpr std::uint32_t max_windows = 4096;
+
+    std::vector<std::uint32_t> ids;
+    if (atoms_.net_client_list != XCB_ATOM_NONE) {
+        const auto cookie = xcb_get_property(connection_, 0, root_, atoms_.net_client_list, XCB_ATOM_WINDOW, 0, max_windows);
+        if (xcb_get_property_reply_t *reply = xcb_get_property_reply(connection_, cookie, nullptr)) {
+            if (reply->type == XCB_ATOM_WINDOW && reply->format == 32) {
+                const auto *data = static_cast<const std::uint32_t *>(xcb_get_property_value(reply));
+                ids.assign(data, data + xcb_get_property_value_length(reply) / 4);
+            }
+            free(reply); // NOLINT(cppcoreguidelines-no-malloc)
+        }
+    }
+
+    // send requests of all windows at once, so the replies are received in one round-trip
+    constexpr std::uint32_t max_name  = 256; // in 32-bit units
+    constexpr std::uint32_t max_state = 32;
+
+    struct cookies {
+        bool                               known, name_valid;
+        xcb_get_window_attributes_cookie_t attributes;
+        xcb_get_property_cookie_t          pid, net_name, name, state;
+    };
+    std::vector<cookies> requests(ids.size());
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        const std::uint32_t id      = ids[i];
+        cookies            &request = requests[i];
+
+        const auto [it, added] = windows_.try_emplace(id);
+        request.known          = !added;
+        request.name_valid     = it->second.name_valid;
+
+        // the name is valid until the event thread receives its change
+        it->second.name_valid = true;
+        if (!request.known) {
+            // receive name changes of the window, it must be done before the name is read
+            const std::uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+            xcb_change_window_attributes(connection_, id, XCB_CW_EVENT_MASK, &mask);
+            request.pid = xcb_get_property(connection_, 0, id, atoms_.net_wm_pid, XCB_ATOM_CARDINAL, 0, 1);
+        }
+        if (!request.name_valid) {
+            request.net_name = xcb_get_property(connection_, 0, id, atoms_.net_wm_name, atoms_.utf8_string, 0, max_name);
+            request.name     = xcb_get_property(connection_, 0, id, XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0, max_name);
+        }
+        request.attributes = xcb_get_window_attributes(connection_, id);
+        request.state      = xcb_get_property(connection_, 0, id, atoms_.net_wm_state, XCB_ATOM_ATOM, 0, max_state);
+    }
+    lock.unlock();
+
+    // the replies are read without the lock, so name changes can be received by the event thread meanwhile
+    struct replies {
+        bool        visible   = false;
+        bool        name_read = false;
+        int         pid       = -1;
+        std::string name;
+    };
+    std::vector<replies> received(ids.size());
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        const cookies &request = requests[i];
+        replies       &reply   = received[i];
+
+        if (!request.known) {
+            auto *pid = xcb_get_property_reply(connection_, request.pid, nullptr);
+            if (pid && pid->type == XCB_ATOM_CARDINAL && pid->format == 32 && xcb_get_property_value_length(pid) >= 4) {
+                reply.pid = static_cast<int>(*static_cast<const std::uint32_t *>(xcb_get_property_value(pid)));
+            }
+            free(pid); // NOLINT(cppcoreguidelines-no-malloc)
+        }
+
+        if (!request.name_valid) {
+            auto *net_name = xcb_get_property_reply(connection_, request.net_name, nullptr);
+            auto *name     = xcb_get_property_reply(connection_, request.name, nullptr);
+
+            // prefer the UTF-8 name of EWMH
+            const xcb_get_property_reply_t *name_reply = net_name && xcb_get_property_value_length(net_name) > 0 ? net_name : name;
+            if (name_reply && name_reply->format == 8) {
+                reply.name.assign(static_cast<const char *>(xcb_get_property_value(name_reply)),
+                                  static_cast<std::size_t>(xcb_get_property_value_length(name_reply)));
+            }
+            reply.name_read = true;
+            free(net_name); // NOLINT(cppcoreguidelines-no-malloc)
+            free(name);     // NOLINT(cppcoreguidelines-no-malloc)
+        }
+
+        auto *attributes = xcb_get_window_attributes_reply(connection_, request.attributes, nullptr);
+        auto *state      = xcb_get_property_reply(connection_, request.state, nullptr);
+        reply.visible    = attributes && attributes->map_state == XCB_MAP_STATE_VIEWABLE;
+        if (state && state->type == XCB_ATOM_ATOM && state->format == 32) {
+            const auto *data = static_cast<const std::uint32_t *>(xcb_get_property_value(state));
+            const auto *end  = data + xcb_get_property_value_length(state) / 4;
+            reply.visible    = reply.visible && std::find(data, end, atoms_.net_wm_state_hidden) == end;
+        }
+        free(attributes); // NOLINT(cppcoreguidelines-no-malloc)
+        free(state);      // NOLINT(cppcoreguidelines-no-malloc)
+    }
+
+    // reading replies moves pending events from the socket into the queue of xcb, where poll of the event thread doesn't see them
+    if (wakeup_ != -1) {
+        eventfd_write(wakeup_, 1);
+    }
+
+    // update the cache and build the result
+    std::vector<window> result;
+    lock.lock();
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        const replies &reply = received[i];
+        cached_window &entry = windows_[ids[i]];
+        if (!requests[i].known) {
+            entry.pid = reply.pid;
+        }
+        if (reply.name_read && (entry.name_version == 0 || entry.name != reply.name)) {
+            entry.name         = reply.name;
+            entry.name_version = ++window_name_version;
+        }
+
+        if (reply.visible || !only_visible) {
+            result.push_back({.id = ids[i], .pid = entry.pid, .name = entry.name, .name_version = entry.name_version});
+        }
+    }
+
+    // forget windows that are no longer managed
+    std::erase_if(windows_, [&ids](const auto &pair) {
+        return std::find(ids.begin(), ids.end(), pair.first) == ids.end();
+    });
+    return result;
+}
+
+std::vector<x11_session::window> x11_session::process_windows(bool only_visible) const {
+    std::vector<window> result = windows(only_visible);
+    std::erase_if(result, [](const window &win) {
+        return win.pid == -1;
+    });
+
+    // keep the first window of each process
+    std::vector<window>::iterator end = result.begin();
+    for (auto it = result.begin(); it != result.end(); it++) {
+        if (std::find_if(result.begin(), end, [pid = it->pid](const window &win) {
+                return win.pid == pid;
+            }) == end) {
+            *end++ = std::move(*it);
+        }
+    }
+    result.erase(end, result.end());
+    return result;
+}
+
+void x11_session::on_focus_change(focus_callback callback) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    focus_callback_ = std::move(callback);
+}
+
+void x11_session::event_thread() {
+    std::array<pollfd, 2> fds = {{
+        {.fd = xcb_get_file_descriptor(connection_), .events = POLLIN, .revents = 0},
+        {.fd = wakeup_, .events = POLLIN, .revents = 0},
+    }};
+
+    while (running_ && !xcb_connection_has_error(connection_)) {
+        if (poll(fds.data(), fds.size(), -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) { // stopped, or woken up to read the events queued by `windows`
+            eventfd_t count = 0;
+            eventfd_read(wakeup_, &count);
+            if (!running_) {
+                break;
+            }
+        }
+
+        // read all queued events, so poll doesn't miss those buffered by xcb
+        bool focus_changed = false;
+        while (xcb_generic_event_t *event = xcb_poll_for_event(connection_)) {
+            const auto time = std::chrono::system_clock::now();
+            if ((event->response_type & ~0x80) == XCB_PROPERTY_NOTIFY) {
+                const auto *notify = std::bit_cast<const xcb_property_notify_event_t *>(event);
+                if (notify->window == root_ && notify->atom == atoms_.net_active_window) {
+                    focus_changed = update_focus(time) || focus_changed;
+                } else if (notify->atom == atoms_.net_wm_name || notify->atom == XCB_ATOM_WM_NAME) {
+                    invalidate_name(notify->window);
+                }
+            }
+            free(event); // NOLINT(cppcoreguidelines-no-malloc)
+        }
+
+        if (focus_changed) {
+            focus_callback callback;
+            {
+                const std::lock_guard<std::mutex> lock{mutex_};
+                callback = focus_callback_;
+            }
+            if (callback) {
+                callback();
+            }
+        }
+    }
+}
+
+void x11_session::invalidate_name(std::uint32_t window) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (const auto it = windows_.find(window); it != windows_.end()) {
+        it->second.name_valid = false;
+    }
+}
+
+bool x11_session::update_focus(time_point since) {
+    std::uint32_t window = 0;
+    property32(root_, atoms_.net_active_window, XCB_ATOM_WINDOW, window);
+
+    std::uint32_t pid     = 0;
+    const bool    has_pid = window != 0 && property32(window, atoms_.net_wm_pid, XCB_ATOM_CARDINAL, pid);
+
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (window == focus_.window && focus_.since != time_point{}) {
+        return false;
+    }
+    focus_.window = window;
+    focus_.pid    = has_pid ? static_cast<int>(pid) : -1;
+    focus_.since  = since;
+    return true;
+}
+
+bool x11_session::property32(std::uint32_t window, std::uint32_t property, std::uint32_t type, std::uint32_t &value) const {
+    const xcb_get_property_cookie_t cookie = xcb_get_property(connection_, 0, window, property, type, 0, 1);
+    xcb_get_property_reply_t       *reply  = xcb_get_property_reply(connection_, cookie, nullptr);
+    if (!reply) {
+        return false;
+    }
+
+    const bool found = reply->type == type && reply->format == 32 && xcb_get_property_value_length(reply) >= 4;
+    if (found) {
+        value = *static_cast<const std::uint32_t *>(xcb_get_property_value(reply));
+    }
+    free(reply); // NOLINT(cppcoreguidelines-no-malloc)
+    return found;
+}
+} // namespace apptime
\ No newline at end of file
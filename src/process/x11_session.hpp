@@ -0,0 +1,169 @@
+#ifndef APPTIME_X11_SESSION_HPP
+#define APPTIME_X11_SESSION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct xcb_connection_t;
+
+namespace apptime {
+/**
+ * @brief The class represents a connection to an X11 server (or XWayland) and tracks EWMH properties of the root window.
+ *
+ * The focused window is tracked by `PropertyNotify` events of `_NET_ACTIVE_WINDOW`, so no polling is needed.
+ * The events are handled by a separate thread. Client windows are listed from `_NET_CLIENT_LIST`, their process IDs and names are cached.
+ * A cached name is fetched again only after a `PropertyNotify` event of `_NET_WM_NAME` or `WM_NAME`.
+ */
+class x11_session {
+public:
+    using time_point     = std::chrono::system_clock::time_point;
+    using focus_callback = std::function<void()>;
+
+    /// @brief The focused window.
+    struct focus {
+        /// @brief The window ID (0 if no window is focused).
+        std::uint32_t window = 0;
+        /// @brief The process ID of the window (-1 if unknown).
+        int pid = -1;
+        /// @brief The time the window got the focus.
+        time_point since;
+    };
+
+    /// @brief A client window.
+    struct window {
+        /// @brief The window ID.
+        std::uint32_t id = 0;
+        /// @brief The process ID of the window (-1 if unknown).
+        int pid = -1;
+        /// @brief The window name.
+        std::string name;
+        /// @brief The version of the window name, it changes only when the name changes (0 if unknown).
+        std::uint64_t name_version = 0;
+    };
+
+    /**
+     * @brief Connect to an X11 server.
+     *
+     * @param display The display name (nullptr to use the DISPLAY environment variable).
+     * @return std::unique_ptr<x11_session> The session, or nullptr if the connection fails or the window manager doesn't support EWMH.
+     */
+    static std::unique_ptr<x11_session> connect(const char *display = nullptr);
+
+    ~x11_session();
+
+    x11_session(const x11_session &)            = delete;
+    x11_session &operator=(const x11_session &) = delete;
+
+    /**
+     * @brief Get the focused window.
+     *
+     * @return focus The focused window.
+     */
+    focus focused() const;
+
+    /**
+     * @brief Get the client windows managed by the window manager.
+     *
+     * All properties of all windows are requested before any reply is read, so the call costs two round-trips regardless of the number of windows.
+     * Process IDs and names of known windows are taken from the cache.
+     *
+     * @param only_visible Get only mapped windows that aren't hidden (e.g. minimized).
+     * @return std::vector<window> A vector of client windows.
+     */
+    std::vector<window> windows(bool only_visible) const;
+
+    /**
+     * @brief Get one client window per process, windows without a process ID are skipped.
+     *
+     * @param only_visible Get only mapped windows that aren't hidden (e.g. minimized).
+     * @return std::vector<window> A vector of client windows.
+     */
+    std::vector<window> process_windows(bool only_visible) const;
+
+    /**
+     * @brief Set the function called from the event thread when the focused window changes.
+     *
+     * @param callback The function.
+     */
+    void on_focus_change(focus_callback callback);
+
+private:
+    /// @brief Atoms used by the session.
+    struct atoms {
+        std::uint32_t net_active_window   = 0;
+        std::uint32_t net_client_list     = 0;
+        std::uint32_t net_wm_pid          = 0;
+        std::uint32_t net_wm_name         = 0;
+        std::uint32_t net_wm_state        = 0;
+        std::uint32_t net_wm_state_hidden = 0;
+        std::uint32_t utf8_string         = 0;
+    };
+
+    /// @brief A cached client window.
+    struct cached_window {
+        int           pid = -1;
+        std::string   name;
+        std::uint64_t name_version = 0;
+        /// @brief false if the name has changed since it was fetched.
+        bool name_valid = false;
+    };
+
+    x11_session(xcb_connection_t *connection, std::uint32_t root, const atoms &atoms);
+
+    /// @brief Receive X11 events until the session is destroyed.
+    void event_thread();
+
+    /**
+     * @brief Mark the cached name of a window as changed, so it's fetched again.
+     *
+     * @param window The window ID.
+     */
+    void invalidate_name(std::uint32_t window);
+
+    /**
+     * @brief Read the focused window from the root window and update the focus.
+     *
+     * @param since The time the focus changed.
+     * @return true if the focused window changed, false otherwise.
+     */
+    bool update_focus(time_point since);
+
+    /**
+     * @brief Read a 32-bit property of a window.
+     *
+     * @param window The window ID.
+     * @param property The property atom.
+     * @param type The property type atom.
+     * @param value The property value.
+     * @return true if the property exists, false otherwise.
+     */
+    bool property32(std::uint32_t window, std::uint32_t property, std::uint32_t type, std::uint32_t &value) const;
+
+    xcb_connection_t *connection_;
+    std::uint32_t     root_;
+    atoms             atoms_;
+
+    /// @brief The eventfd used to wake up the event thread, when the session is destroyed and after `windows` read replies.
+    int wakeup_ = -1;
+
+    mutable std::mutex mutex_;
+    focus              focus_;
+    focus_callback     focus_callback_;
+
+    /// @brief Client windows by window ID.
+    mutable std::unordered_map<std::uint32_t, cached_window> windows_;
+
+    std::thread      thread_;
+    std::atomic_bool running_;
+};
+} // namespace apptime
+
+#endif // APPTIME_X11_SESSION_HPP
\ No newline at end of file
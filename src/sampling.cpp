@@ -0,0 +1,82 @@
+#include "sampling.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace apptime {
+std::span<const process_entry> filter_windows(process_buffer &buffer, process_tree &tree) {
+    if (!tree.empty()) {
+        tree.fold(buffer);
+    }
+
+    // processes of a known executable are grouped by its id, paths are compared only for processes without one
+    const auto same_executable = [](const process_entry &lhs, const process_entry &rhs) {
+        return lhs.exe_id == rhs.exe_id && (lhs.exe_id != 0 || lhs.full_path == rhs.full_path);
+    };
+    const auto entries = buffer.entries();
+    std::ranges::sort(entries, [](const process_entry &lhs, const process_entry &rhs) {
+        if (lhs.exe_id != rhs.exe_id) {
+            return lhs.exe_id < rhs.exe_id;
+        }
+        if (lhs.exe_id == 0 && lhs.full_path != rhs.full_path) {
+            return lhs.full_path < rhs.full_path;
+        }
+        return lhs.start < rhs.start;
+    });
+
+    std::size_t               size = 0;
+    std::chrono::milliseconds cpu_time{0};
+    std::uint64_t             rss = 0;
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].full_path.empty()) {
+            continue;
+        }
+        cpu_time += entries[i].cpu_time;
+        rss += entries[i].rss;
+
+        // keep one process per executable, the last one in the sorted order
+        if (i + 1 < entries.size() && same_executable(entries[i + 1], entries[i])) {
+            continue;
+        }
+        entries[size]          = entries[i];
+        entries[size].cpu_time = std::exchange(cpu_time, {});
+        entries[size].rss      = std::exchange(rss, 0);
+        size++;
+    }
+    return entries.first(size);
+}
+
+record build_record(process_info info) {
+    record result;
+    result.name         = std::move(info.window_name);
+    result.path         = std::move(info.full_path);
+    result.name_version = info.name_version;
+    result.exe_id       = info.exe_id;
+    result.device       = info.exe.device;
+    result.inode        = info.exe.inode;
+    result.mtime        = info.exe.mtime;
+    result.times.emplace_back(info.start, std::chrono::system_clock::now());
+    return result;
+}
+
+void build_record(const process_entry &entry, record &result) {
+    result.name.assign(entry.window_name);
+    result.path.assign(entry.full_path);
+    result.name_version = entry.name_version;
+    result.exe_id       = entry.exe_id;
+    result.device       = entry.exe.device;
+    result.inode        = entry.exe.inode;
+    result.mtime        = entry.exe.mtime;
+    result.times.clear();
+    result.times.emplace_back(entry.start, std::chrono::system_clock::now());
+}
+
+record build_record(std::unique_ptr<process> proc, bool focused) {
+    record result;
+    result.name = proc->window_name();
+    result.path = proc->full_path();
+    result.times.emplace_back(focused ? proc->focused_start() : proc->start(), std::chrono::system_clock::now());
+    return result;
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef APPTIME_SAMPLING_HPP
+#define APPTIME_SAMPLING_HPP
+
+#include <memory>
+#include <span>
+
+#include "database/database.hpp"
+#include "process/process.hpp"
+#include "process/process_buffer.hpp"
+#include "process/process_tree.hpp"
+
+// the stages of a sampler cycle after the manager took a snapshot: the processes are filtered to one per application
+// and records are built from them, monitoring passes the records to the writer thread. the stages don't depend on
+// the state of monitoring, so they can be tested on their own
+namespace apptime {
+/**
+ * @brief Filter a snapshot of processes with windows to the processes written by monitoring.
+ *
+ * Helper processes are attributed to their applications first, if the tree has rules.
+ * One process is kept per executable, its usage is the sum of all processes of the application.
+ * Processes without an executable path are dropped.
+ * The buffer is filtered in place, so a reused buffer doesn't allocate memory.
+ *
+ * @param buffer The snapshot, it's reordered and overwritten.
+ * @param tree The rules of helper processes.
+ * @return std::span<const process_entry> The written processes, ordered by executable.
+ */
+std::span<const process_entry> filter_windows(process_buffer &buffer, process_tree &tree);
+
+/**
+ * @brief Fill a record of a process, the record keeps its memory between cycles.
+ *
+ * @param entry The process.
+ * @param result The record, its interval is from the start of the process until now.
+ */
+void build_record(const process_entry &entry, record &result);
+
+/**
+ * @brief Build a record of a process whose exit is waited.
+ *
+ * @param info The process.
+ * @return record The record, its interval is from the start of the process until now.
+ */
+record build_record(process_info info);
+
+/**
+ * @brief Build a record of a process.
+ *
+ * @param proc The process.
+ * @param focused The interval starts when the window was focused instead of when the process started.
+ * @return record The record, its interval ends now.
+ */
+record build_record(std::unique_ptr<process> proc, bool focused = false);
+} // namespace apptime
+
+#endif // APPTIME_SAMPLING_HPP
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef __linux__
+#include <array>
+#include <cstdint>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace apptime {
+scheduler::scheduler(clock::duration slack) : slack_{slack} {
+#ifdef __linux__
+    // std::chrono::steady_clock is CLOCK_MONOTONIC, so deadlines are passed to the timer as they are
+    timer_  = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    wakeup_ = eventfd(0, EFD_CLOEXEC);
+#endif
+}
+
+scheduler::~scheduler() {
+    stop();
+#ifdef __linux__
+    if (timer_ != -1) {
+        close(timer_);
+    }
+    if (wakeup_ != -1) {
+        close(wakeup_);
+    }
+#endif
+}
+
+std::size_t scheduler::add(std::string name, task fn) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+
+    entry &added     = tasks_.emplace_back();
+    added.fn         = std::move(fn);
+    added.stats.name = std::move(name);
+    return tasks_.size() - 1;
+}
+
+void scheduler::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        const clock::time_point           now = clock::now();
+        for (auto &added: tasks_) {
+            added.deadline = now;
+            added.woken    = false;
+        }
+        running_  = true;
+        signaled_ = false;
+    }
+    thread_ = std::thread{&scheduler::run, this};
+}
+
+void scheduler::stop() {
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        running_  = false;
+        signaled_ = true;
+    }
+    signal();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void scheduler::wake(std::size_t id) {
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        if (id >= tasks_.size()) {
+            return;
+        }
+        tasks_[id].woken = true;
+        signaled_        = true;
+    }
+    signal();
+}
+
+std::vector<scheduler::task_stats> scheduler::stats() const {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    std::vector<task_stats>           result;
+    result.reserve(tasks_.size());
+    for (const auto &added: tasks_) {
+        result.push_back(added.stats);
+    }
+    return result;
+}
+
+void scheduler::run() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    while (running_) {
+        signaled_ = false;
+
+        // run the due tasks, tasks_ isn't resized while the thread runs, so the entries stay in place.
+        // a task due within the slack runs now, its deadline still follows the period
+        const clock::time_point now = clock::now();
+        for (auto &due: tasks_) {
+            if (!running_) {
+                break;
+            }
+            if (!due.woken && due.deadline > now + slack_) {
+                continue;
+            }
+            const bool              woken    = std::exchange(due.woken, false);
+            const clock::time_point deadline = due.deadline;
+
+            lock.unlock();
+            const clock::time_point started = clock::now();
+            const clock::duration   delay   = due.fn();
+            lock.lock();
+
+            const clock::duration late = deadline < started ? started - deadline : clock::duration{0};
+            due.stats.runs++;
+            due.stats.last_late = late;
+            due.stats.max_late  = std::max(due.stats.max_late, late);
+            due.stats.total_late += late;
+            due.deadline = next_deadline(deadline, started, delay, woken);
+        }
+
+        // sleep until the earliest deadline, unless a task was woken meanwhile
+        clock::time_point earliest = clock::time_point::max();
+        bool              woken    = false;
+        for (const auto &next: tasks_) {
+            earliest = std::min(earliest, next.deadline);
+            woken    = woken || next.woken;
+        }
+        if (running_ && !woken) {
+            wait(lock, earliest);
+        }
+    }
+}
+
+void scheduler::wait(std::unique_lock<std::mutex> &lock, clock::time_point deadline) {
+#ifdef __linux__
+    if (timer_ != -1 && wakeup_ != -1) {
+        // a zero value disarms the timer, so the thread sleeps until it's woken
+        itimerspec spec = {};
+        if (deadline != clock::time_point::max()) {
+            const auto since_epoch = deadline.time_since_epoch();
+            const auto seconds     = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+            spec.it_value.tv_sec   = seconds.count();
+            spec.it_value.tv_nsec  = std::max<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds).count(), 1);
+        }
+
+        // a task woken after the lock is released leaves the eventfd readable, so the wakeup isn't lost
+        lock.unlock();
+        timerfd_settime(timer_, TFD_TIMER_ABSTIME, &spec, nullptr);
+        std::array<pollfd, 2> fds = {{
+            {.fd = timer_, .events = POLLIN, .revents = 0},
+            {.fd = wakeup_, .events = POLLIN, .revents = 0},
+        }};
+        if (poll(fds.data(), fds.size(), -1) > 0) {
+            std::uint64_t value = 0;
+            if (fds[0].revents & POLLIN) {
+                static_cast<void>(read(timer_, &value, sizeof value));
+            }
+            if (fds[1].revents & POLLIN) {
+                eventfd_read(wakeup_, &value);
+            }
+        }
+        lock.lock();
+        return;
+    }
+#endif
+
+    const auto signaled = [this] {
+        return !running_ || signaled_;
+    };
+    if (deadline == clock::time_point::max()) {
+        cv_.wait(lock, signaled);
+    } else {
+        cv_.wait_until(lock, deadline, signaled);
+    }
+}
+
+void scheduler::signal() {
+    cv_.notify_one();
+#ifdef __linux__
+    if (wakeup_ != -1) {
+        eventfd_write(wakeup_, 1);
+    }
+#endif
+}
+
+scheduler::clock::time_point scheduler::next_deadline(clock::time_point deadline, clock::time_point started, clock::duration delay, bool woken) {
+    if (delay == never) {
+        return clock::time_point::max();
+    }
+    if (delay <= clock::duration{0}) {
+        return started;
+    }
+    if (deadline == clock::time_point::max() || (woken && deadline > started)) {
+        return started + delay;
+    }
+
+    // skip the periods missed by a late run, so the task doesn't run several times in a row
+    clock::time_point result = deadline + delay;
+    if (result <= started) {
+        result += delay * ((started - result) / delay + 1);
+    }
+    return result;
+}
+} // namespace apptime
\ No newline at end of file
@@ -0,0 +1,122 @@
+#ifndef APPTIME_SCHEDULER_HPP
+#define APPTIME_SCHEDULER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace apptime {
+/**
+ * @brief The class runs periodic tasks by one thread.
+ *
+ * Every task has an absolute deadline, the next one is its last deadline plus the delay returned by the task,
+ * so the time a task takes doesn't shift its period. A task that is late by more than a period skips the missed runs.
+ * On Linux the thread sleeps on a timerfd armed at the earliest deadline, elsewhere on a condition variable.
+ *
+ * The kernel doesn't apply the timer slack of a thread to timerfd timers, so the scheduler applies its own slack:
+ * tasks due within the slack of a wakeup run in it, a little early, instead of waking the thread again.
+ */
+class scheduler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief The function of a task.
+     *
+     * @return clock::duration The delay before the next run, or `never` to run only when the task is woken.
+     */
+    using task = std::function<clock::duration()>;
+
+    static constexpr clock::duration never = clock::duration::max();
+
+    /// @brief The lateness of a task, it's the time between its deadline and its run.
+    struct task_stats {
+        std::string     name;
+        std::uint64_t   runs = 0;
+        clock::duration last_late{0};
+        clock::duration max_late{0};
+        clock::duration total_late{0};
+    };
+
+    /**
+     * @brief Construct a new scheduler.
+     *
+     * @param slack The time a task can run before its deadline to share a wakeup with another task.
+     */
+    explicit scheduler(clock::duration slack = clock::duration{0});
+    ~scheduler();
+
+    scheduler(const scheduler &)            = delete;
+    scheduler &operator=(const scheduler &) = delete;
+
+    /**
+     * @brief Add a task, it can't be called while the scheduler is running.
+     *
+     * @param name The name of the task in the statistics.
+     * @param fn The function of the task.
+     * @return std::size_t The ID of the task.
+     */
+    std::size_t add(std::string name, task fn);
+
+    /// @brief Start the thread, every task runs at once.
+    void start();
+    /// @brief Stop the thread, it waits for the running task.
+    void stop();
+
+    /**
+     * @brief Run a task as soon as possible, it can be called by any thread.
+     *
+     * A task woken before its deadline starts a new period from the run.
+     *
+     * @param id The ID of the task.
+     */
+    void wake(std::size_t id);
+
+    std::vector<task_stats> stats() const;
+
+private:
+    struct entry {
+        task              fn;
+        clock::time_point deadline;
+        bool              woken = false;
+        task_stats        stats;
+    };
+
+    void run();
+
+    /**
+     * @brief Sleep until the deadline or until a task is woken.
+     *
+     * @param lock The lock of the mutex, it's released while the thread sleeps.
+     * @param deadline The earliest deadline (time_point::max() to sleep until a task is woken).
+     */
+    void wait(std::unique_lock<std::mutex> &lock, clock::time_point deadline);
+
+    // the deadline after a run, the period is kept unless the task was woken before its deadline
+    static clock::time_point next_deadline(clock::time_point deadline, clock::time_point started, clock::duration delay, bool woken);
+
+    // wake up the thread after a task is woken or the scheduler is stopped
+    void signal();
+
+    clock::duration slack_;
+
+    /// @brief The timerfd and the eventfd used to wake up the thread (-1 if they aren't available).
+    int timer_  = -1;
+    int wakeup_ = -1;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable cv_;
+    std::vector<entry>      tasks_;
+    bool                    running_  = false;
+    bool                    signaled_ = false;
+
+    std::thread thread_;
+};
+} // namespace apptime
+
+#endif // APPTIME_SCHEDULER_HPP
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef APPTIME_SPSC_QUEUE_HPP
+#define APPTIME_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+namespace apptime {
+/**
+ * @brief A bounded lock-free queue with a single producer thread and a single consumer thread.
+ *
+ * Elements are filled and read in place: the producer fills the slot returned by `back` and publishes it by `push`,
+ * the consumer reads the slot returned by `front` and releases it by `pop`. Released slots keep their elements,
+ * so elements that own memory (e.g. strings) reuse it when the slot is filled again.
+ *
+ * @tparam T The element type.
+ */
+template <typename T>
+class spsc_queue {
+public:
+    /**
+     * @brief Construct a new queue.
+     *
+     * @param capacity The maximum number of elements, it's rounded up to a power of two.
+     */
+    explicit spsc_queue(std::size_t capacity) : slots_(std::bit_ceil(capacity)), mask_{slots_.size() - 1} {}
+
+    /**
+     * @brief Get the slot of the next element (producer).
+     *
+     * @return T* The slot, or nullptr if the queue is full.
+     */
+    T *back() {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == slots_.size()) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == slots_.size()) {
+                return nullptr;
+            }
+        }
+        return &slots_[tail & mask_];
+    }
+
+    /// @brief Publish the slot returned by `back` (producer).
+    void push() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    /**
+     * @brief Get the oldest element (consumer).
+     *
+     * @return T* The element, or nullptr if the queue is empty.
+     */
+    T *front() {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return nullptr;
+            }
+        }
+        return &slots_[head & mask_];
+    }
+
+    /// @brief Release the element returned by `front` (consumer).
+    void pop() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    /**
+     * @brief Get the number of elements, it can be called by any thread.
+     *
+     * Elements published by the producer before the call are counted, so the consumer can read at least this number of elements.
+     *
+     * @return std::size_t The number of elements.
+     */
+    std::size_t size() const {
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    std::size_t capacity() const { return slots_.size(); }
+
+private:
+    /// @brief The size of a cache line, the indexes of the producer and the consumer are kept apart to avoid false sharing.
+    static constexpr std::size_t cache_line = 64;
+
+    std::vector<T> slots_;
+    std::size_t    mask_;
+
+    /// @brief The index of the next element to read and the last known index of the producer (used only by the consumer).
+    alignas(cache_line) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_ = 0;
+
+    /// @brief The index of the next element to write and the last known index of the consumer (used only by the producer).
+    alignas(cache_line) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_ = 0;
+};
+} // namespace apptime
+
+#endif // APPTIME_SPSC_QUEUE_HPP
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <fstream>
 
 #include <SQLiteCpp/SQLiteCpp.h>
 #include <sqlite3.h>
@@ -24,6 +25,10 @@ std::vector<apptime::record> processes;
 const struct {
     fs::path ele_add    = fs::temp_directory_path() / "apptime_ele_add.db";
     fs::path ele_search = fs::temp_directory_path() / "apptime_ele_search.db";
+    fs::path usage      = fs::temp_directory_path() / "apptime_usage.db";
+    fs::path migration  = fs::temp_directory_path() / "apptime_migration.db";
+    fs::path identity   = fs::temp_directory_path() / "apptime_identity.db";
+    fs::path journal    = fs::temp_directory_path() / "apptime_journal.db";
 } test_paths;
 
 template <typename It = std::vector<apptime::record>::iterator>
@@ -188,9 +193,245 @@ TEST_CASE("element search") {
     }
 }
 
+TEST_CASE("resource usage") {
+    apptime::database_sqlite db{test_paths.usage};
+
+    SECTION("intervals") {
+        apptime::record rec = processes.front();
+        const auto      start = rec.times.front().first;
+
+        rec.times    = {{start, start + 1h}};
+        rec.cpu_time = 90s;
+        rec.rss_peak = 300;
+        rec.rss_avg  = 100;
+        REQUIRE(db.add_active(rec));
+
+        // the second interval is 3 times longer, so its average weighs 3 times more
+        rec.times    = {{start + 2h, start + 5h}};
+        rec.cpu_time = 10s;
+        rec.rss_peak = 500;
+        rec.rss_avg  = 200;
+        REQUIRE(db.add_active(rec));
+
+        apptime::database::options opt;
+        opt.path           = rec.path;
+        const auto actives = db.actives(opt);
+        REQUIRE(actives.size() == 1);
+        REQUIRE(actives[0].times.size() == 2);
+        REQUIRE(actives[0].cpu_time == 100s);
+        REQUIRE(actives[0].rss_peak == 500);
+        REQUIRE(actives[0].rss_avg == 175);
+
+        // focus intervals have no usage
+        REQUIRE(db.add_focus(rec));
+        const auto focuses = db.focuses(opt);
+        REQUIRE(focuses.size() == 1);
+        REQUIRE(focuses[0].cpu_time == 0s);
+    }
+
+    SECTION("migration") {
+        const apptime::record &rec = processes.front();
+        std::filesystem::remove(test_paths.migration);
+        {
+            // the schema before the resource usage
+            SQLite::Database old{test_paths.migration.string(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE};
+            old.exec("CREATE TABLE applications (id INTEGER NOT NULL, path TEXT NOT NULL UNIQUE, name TEXT NOT NULL, PRIMARY KEY (id AUTOINCREMENT))");
+            old.exec("CREATE TABLE active_logs (program_id INTEGER NOT NULL, start TIMESTAMP NOT NULL, end TIMESTAMP NOT NULL, "
+                     "PRIMARY KEY (program_id, start), FOREIGN KEY (program_id) REFERENCES applications(id))");
+            old.exec(std::format("INSERT INTO applications (path, name) VALUES ('{}', '{}')", rec.path, rec.name));
+            old.exec("INSERT INTO active_logs VALUES (1, '2023-01-01 10:00:00', '2023-01-01 11:00:00')");
+        }
+
+        apptime::database_sqlite   migrated{test_paths.migration};
+        apptime::database::options opt;
+        opt.path           = rec.path;
+        const auto actives = migrated.actives(opt);
+        REQUIRE(actives.size() == 1);
+        REQUIRE(actives[0].cpu_time == 0s);
+        REQUIRE(migrated.add_active(rec));
+    }
+}
+
+TEST_CASE("executable identity") {
+    std::filesystem::remove(test_paths.identity);
+    apptime::database_sqlite db{test_paths.identity};
+
+    apptime::record rec = processes.front();
+    const auto      start = rec.times.front().first;
+    rec.exe_id            = 1;
+    rec.device            = 2049;
+    rec.inode             = 1234;
+    rec.mtime             = 1'700'000'000'000'000'000;
+    REQUIRE(db.add_active(rec));
+
+    apptime::database::options opt;
+    opt.path = rec.path;
+
+    SECTION("renamed") {
+        // a renamed executable is found by its identity in a later session
+        apptime::database_sqlite reopened{test_paths.identity};
+        apptime::record          renamed = rec;
+        renamed.path += "-renamed";
+        renamed.times = {{start + 2h, start + 3h}};
+        REQUIRE(reopened.add_active(renamed));
+
+        REQUIRE(reopened.actives(opt).at(0).times.size() == 2);
+        opt.path = renamed.path;
+        REQUIRE(reopened.actives(opt).empty());
+    }
+
+    SECTION("upgraded") {
+        apptime::record upgraded = rec;
+        upgraded.exe_id          = 2;
+        upgraded.inode           = 5678;
+        upgraded.mtime += 1;
+        upgraded.times = {{start + 2h, start + 3h}};
+        REQUIRE(db.add_active(upgraded));
+        REQUIRE(db.actives(opt).at(0).times.size() == 2);
+
+        // the old identity is replaced, so a file that reuses the inode is another application
+        apptime::record other = processes.back();
+        other.exe_id          = 3;
+        other.device          = rec.device;
+        other.inode           = rec.inode;
+        other.mtime           = rec.mtime;
+        REQUIRE(db.add_active(other));
+        opt.path = other.path;
+        REQUIRE(db.actives(opt).size() == 1);
+    }
+
+    SECTION("ignored") {
+        db.add_ignore(apptime::ignore_file, rec.path);
+        REQUIRE_FALSE(db.add_active(rec));
+        db.remove_ignore(apptime::ignore_file, rec.path);
+        REQUIRE(db.add_active(rec));
+    }
+
+    SECTION("name version") {
+        apptime::record named = rec;
+        named.name            = "first";
+        named.name_version    = 1;
+        named.times           = {{start + 2h, start + 3h}};
+        REQUIRE(db.add_active(named));
+        REQUIRE(db.actives(opt).at(0).name == "first");
+
+        // the name isn't written again while its version is unchanged
+        named.name  = "second";
+        named.times = {{start + 4h, start + 5h}};
+        REQUIRE(db.add_active(named));
+        REQUIRE(db.actives(opt).at(0).name == "first");
+
+        // a new version rewrites it
+        named.name_version = 2;
+        named.times        = {{start + 6h, start + 7h}};
+        REQUIRE(db.add_active(named));
+        REQUIRE(db.actives(opt).at(0).name == "second");
+        REQUIRE(db.actives(opt).at(0).times.size() == 4);
+    }
+
+    SECTION("no name version") {
+        // a record without a window is cached by its name, so the same name doesn't touch the applications
+        SQLite::Database{test_paths.identity.string(), SQLite::OPEN_READWRITE}.exec("UPDATE applications SET name='external'");
+        apptime::record unnamed = rec;
+        unnamed.times           = {{start + 2h, start + 3h}};
+        REQUIRE(db.add_active(unnamed));
+        REQUIRE(db.actives(opt).at(0).name == "external");
+
+        // another name is written
+        unnamed.name  = "renamed";
+        unnamed.times = {{start + 4h, start + 5h}};
+        REQUIRE(db.add_active(unnamed));
+        REQUIRE(db.actives(opt).at(0).name == "renamed");
+    }
+}
+
+TEST_CASE("journal") {
+    const fs::path journal_file = test_paths.journal.string() + ".journal";
+    std::filesystem::remove(test_paths.journal);
+    std::filesystem::remove(journal_file);
+
+    std::vector<apptime::record> actives{processes.begin(), processes.begin() + 3};
+    actives[0].name     = "tab\tname\\n";
+    actives[0].cpu_time = 1500ms;
+    actives[0].rss_peak = 4096;
+    const std::vector<apptime::record> focuses{processes.at(3)};
+
+    {
+        // the database is closed without adding the records, as if the application crashed
+        apptime::database_sqlite db{test_paths.journal};
+        REQUIRE(db.journal(actives, {}));
+        REQUIRE(db.journal({}, focuses));
+        REQUIRE(fs::exists(journal_file));
+    }
+    {
+        // an append interrupted by the crash
+        std::ofstream file{journal_file, std::ios::app | std::ios::binary};
+        file << "a\t1\t2";
+    }
+
+    apptime::database_sqlite   db{test_paths.journal};
+    apptime::database::options opt;
+    REQUIRE_FALSE(fs::exists(journal_file));
+    REQUIRE(db.actives(opt).size() == 3);
+    REQUIRE(db.focuses(opt).size() == 1);
+
+    opt.path                    = actives[0].path;
+    const apptime::record found = db.actives(opt).at(0);
+    REQUIRE(found.name == actives[0].name);
+    REQUIRE(found.times == actives[0].times);
+    REQUIRE(found.cpu_time == 1500ms);
+    REQUIRE(found.rss_peak == 4096);
+
+    SECTION("batch") {
+        // a journaled interval is replaced by the batch that ends it
+        apptime::record ended = actives[1];
+        ended.times.front().second += 1h;
+        REQUIRE(db.journal({&ended, 1}, {}));
+        REQUIRE(db.add_records({&ended, 1}, focuses));
+        REQUIRE_FALSE(fs::exists(journal_file));
+
+        opt.path = ended.path;
+        REQUIRE(db.actives(opt).at(0).times == ended.times);
+    }
+
+    SECTION("ignored") {
+        db.add_ignore(apptime::ignore_file, actives[2].path);
+        REQUIRE_FALSE(db.add_records(actives, {}));
+        REQUIRE(db.add_records({}, {}));
+    }
+}
+
+TEST_CASE("journal identifiers") {
+    const fs::path journal_file = test_paths.journal.string() + ".journal";
+    std::filesystem::remove(test_paths.journal);
+    std::filesystem::remove(journal_file);
+
+    // an ignored application journaled by the run that crashed
+    apptime::record ignored = processes.at(4);
+    ignored.exe_id          = 7;
+    ignored.name_version    = 1;
+    {
+        apptime::database_sqlite db{test_paths.journal};
+        db.add_ignore(apptime::ignore_file, ignored.path);
+        REQUIRE(db.journal({&ignored, 1}, {}));
+    }
+
+    // the next run gives its executable ID to another application
+    apptime::database_sqlite db{test_paths.journal};
+    REQUIRE_FALSE(fs::exists(journal_file));
+    apptime::record other = processes.at(5);
+    other.exe_id          = 7;
+    other.name_version    = 1;
+    REQUIRE(db.add_active(other));
+}
+
 TEST_CASE("cleanup") {
     REQUIRE_NOTHROW(std::filesystem::remove(test_paths.ele_add));
     REQUIRE_NOTHROW(std::filesystem::remove(test_paths.ele_search));
+    REQUIRE_NOTHROW(std::filesystem::remove(test_paths.usage));
+    REQUIRE_NOTHROW(std::filesystem::remove(test_paths.migration));
+    REQUIRE_NOTHROW(std::filesystem::remove(test_paths.identity));
+    REQUIRE_NOTHROW(std::filesystem::remove(test_paths.journal));
 }
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,232 @@
+// NOLINTBEGIN(readability-function-cognitive-complexity, misc-use-anonymous-namespace, cppcoreguidelines-avoid-do-while)
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <catch2/catch_session.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "platforms/desktop_index.hpp"
+#include "platforms/icon_theme.hpp"
+#include "utils.hpp"
+
+using namespace std::chrono_literals;
+
+namespace fs = std::filesystem;
+
+// data directories of a user and of the system in a temporary directory, executables are in <root>/bin
+class desktop_dirs {
+public:
+    desktop_dirs() : root_{fs::temp_directory_path() / ("apptime-desktop-" + random_string(8))} {
+        fs::create_directories(home());
+        fs::create_directories(system());
+        fs::create_directories(root_ / "bin");
+    }
+
+    ~desktop_dirs() {
+        std::error_code ec;
+        fs::remove_all(root_, ec);
+    }
+
+    desktop_dirs(const desktop_dirs &)            = delete;
+    desktop_dirs &operator=(const desktop_dirs &) = delete;
+
+    const fs::path &root() const { return root_; }
+    fs::path        home() const { return root_ / "home/applications"; }
+    fs::path        system() const { return root_ / "system/applications"; }
+    fs::path        cache() const { return root_ / "cache/desktop-index"; }
+
+    static void write(const fs::path &file, const std::string &content) {
+        fs::create_directories(file.parent_path());
+        std::ofstream{file} << "[Desktop Entry]\nType=Application\n" << content;
+    }
+
+private:
+    fs::path root_;
+};
+
+TEST_CASE("desktop entry") {
+    apptime::desktop_entry entry;
+
+    SECTION("application") {
+        std::istringstream input{"# comment\n"
+                                 "[Desktop Entry]\n"
+                                 "Type=Application\n"
+                                 "Name=Text Editor\n"
+                                 "Name[de]=Texteditor\n"
+                                 "Name[fr_FR]=Editeur\n"
+                                 "Icon=accessories-text-editor\n"
+                                 "Exec=env LANG=C \"/opt/text editor/bin/editor\" %F\n"
+                                 "TryExec=editor\n"
+                                 "\n"
+                                 "[Desktop Action new-window]\n"
+                                 "Name=New Window\n"
+                                 "Exec=other\n"};
+        REQUIRE(apptime::parse_desktop_entry(input, "de_DE", entry));
+        REQUIRE(entry.name == "Texteditor");
+        REQUIRE(entry.icon == "accessories-text-editor");
+        REQUIRE(entry.programs == std::vector<std::string>{"/opt/text editor/bin/editor", "editor"});
+        REQUIRE_FALSE(entry.hidden);
+    }
+
+    SECTION("untranslated") {
+        std::istringstream input{"[Desktop Entry]\nName[de]=Texteditor\nName=Text Editor\nType=Application\nExec=editor\n"};
+        REQUIRE(apptime::parse_desktop_entry(input, "", entry));
+        REQUIRE(entry.name == "Text Editor");
+    }
+
+    SECTION("not an application") {
+        std::istringstream input{"[Desktop Entry]\nType=Link\nName=Website\nURL=https://example.com\n"};
+        REQUIRE_FALSE(apptime::parse_desktop_entry(input, "", entry));
+    }
+}
+
+TEST_CASE("desktop index") {
+    const desktop_dirs dirs;
+
+    // the entry points to a symbolic link, processes have the path of its target
+    const fs::path viewer = dirs.root() / "bin/viewer";
+    std::ofstream{viewer};
+    fs::create_symlink(viewer, dirs.root() / "bin/viewer-link");
+    desktop_dirs::write(dirs.system() / "viewer.desktop", std::format("Name=Viewer\nIcon=viewer\nExec={} %U\n", (dirs.root() / "bin/viewer-link").string()));
+
+    // the ID of an entry in a subdirectory includes the subdirectory, the entry of the user hides the one of the system
+    desktop_dirs::write(dirs.system() / "kde/editor.desktop", "Name=Editor\nExec=editor\n");
+    desktop_dirs::write(dirs.home() / "kde-editor.desktop", "Name=My Editor\nExec=editor\n");
+    desktop_dirs::write(dirs.system() / "player.desktop", "Name=Player\nExec=player\n");
+    desktop_dirs::write(dirs.home() / "player.desktop", "Name=Player\nExec=player\nHidden=true\n");
+
+    // a launcher doesn't identify the application
+    desktop_dirs::write(dirs.system() / "script.desktop", "Name=Script\nExec=python3 /opt/script/main.py\n");
+
+    apptime::desktop_index index{{dirs.home(), dirs.system()}, dirs.cache(), ""};
+    const auto             name_of = [](const apptime::desktop_index &index, std::string_view executable) {
+        const apptime::desktop_entry *entry = index.find(executable);
+        return entry ? entry->name : std::string{};
+    };
+    REQUIRE_FALSE(index.cached());
+    REQUIRE(index.size() == 3);
+    REQUIRE(name_of(index, viewer.string()) == "Viewer");
+    REQUIRE(name_of(index, "/usr/lib/editor/editor") == "My Editor");
+    REQUIRE(name_of(index, "/usr/bin/player").empty());
+    REQUIRE(name_of(index, "/usr/bin/python3").empty());
+
+    SECTION("cache") {
+        const apptime::desktop_index cached{{dirs.home(), dirs.system()}, dirs.cache(), ""};
+        REQUIRE(cached.cached());
+        REQUIRE(cached.size() == 3);
+        REQUIRE(name_of(cached, viewer.string()) == "Viewer");
+        REQUIRE(cached.find(viewer.string())->icon == "viewer");
+        REQUIRE(name_of(cached, "/usr/lib/editor/editor") == "My Editor");
+
+        // other directories or locale
+        REQUIRE_FALSE(apptime::desktop_index{{dirs.system()}, dirs.cache(), ""}.cached());
+        REQUIRE_FALSE(apptime::desktop_index{{dirs.home(), dirs.system()}, dirs.cache(), "de_DE"}.cached());
+
+        // a changed directory, the modification time has the resolution of a clock tick
+        std::this_thread::sleep_for(20ms);
+        desktop_dirs::write(dirs.system() / "kde/terminal.desktop", "Name=Terminal\nExec=terminal\n");
+        const apptime::desktop_index rebuilt{{dirs.home(), dirs.system()}, dirs.cache(), ""};
+        REQUIRE_FALSE(rebuilt.cached());
+        REQUIRE(name_of(rebuilt, "/usr/bin/terminal") == "Terminal");
+    }
+
+#ifdef __linux__
+    SECTION("refresh") {
+        REQUIRE_FALSE(index.refresh());
+
+        desktop_dirs::write(dirs.home() / "terminal.desktop", "Name=Terminal\nExec=terminal\n");
+        REQUIRE(index.refresh());
+        REQUIRE(name_of(index, "/usr/bin/terminal") == "Terminal");
+        REQUIRE_FALSE(index.refresh());
+
+        // a new subdirectory is watched after the rebuild
+        desktop_dirs::write(dirs.home() / "new/browser.desktop", "Name=Browser\nExec=browser\n");
+        REQUIRE(index.refresh());
+        desktop_dirs::write(dirs.home() / "new/mail.desktop", "Name=Mail\nExec=mail\n");
+        REQUIRE(index.refresh());
+        REQUIRE(name_of(index, "/usr/bin/mail") == "Mail");
+    }
+
+    SECTION("changed") {
+        // the change is reported once and the index is left as is
+        desktop_dirs::write(dirs.home() / "terminal.desktop", "Name=Terminal\nExec=terminal\n");
+        REQUIRE(index.changed());
+        REQUIRE_FALSE(index.changed());
+        REQUIRE(name_of(index, "/usr/bin/terminal").empty());
+    }
+
+    SECTION("missing directory") {
+        // the directory of the user is created with the first entry, other changes of its parents are ignored
+        const fs::path         missing = dirs.root() / "local/share/applications";
+        apptime::desktop_index watched{{missing, dirs.system()}, {}, ""};
+        fs::create_directories(dirs.root() / "other");
+        REQUIRE_FALSE(watched.refresh());
+
+        desktop_dirs::write(missing / "terminal.desktop", "Name=Terminal\nExec=terminal\n");
+        REQUIRE(watched.refresh());
+        REQUIRE(name_of(watched, "/usr/bin/terminal") == "Terminal");
+    }
+#endif
+}
+
+TEST_CASE("icon theme") {
+    const desktop_dirs dirs;
+    const fs::path     user = dirs.root() / "icons", system = dirs.root() / "system/icons", pixmaps = dirs.root() / "pixmaps";
+    const auto         write = [](const fs::path &file, const std::string &content = {}) {
+        fs::create_directories(file.parent_path());
+        std::ofstream{file} << content;
+    };
+
+    write(system / "breeze/index.theme", "[Icon Theme]\nName=Breeze\nInherits=base\nDirectories=apps/16,apps/48,apps/scalable\n\n"
+                                         "[apps/16]\nSize=16\nType=Fixed\n\n[apps/48]\nSize=48\nType=Fixed\n\n"
+                                         "[apps/scalable]\nSize=48\nMinSize=64\nMaxSize=512\nType=Scalable\n");
+    write(system / "breeze/apps/16/editor.png");
+    write(system / "breeze/apps/48/editor.png");
+    write(system / "breeze/apps/48/editor.svg");
+    write(system / "breeze/apps/scalable/editor.svg");
+    write(system / "breeze/apps/scalable/viewer.svg");
+    write(system / "base/index.theme", "[Icon Theme]\nDirectories=32x32/apps\n[32x32/apps]\nSize=32\n");
+    write(system / "base/32x32/apps/player.png");
+    write(system / "hicolor/index.theme", "[Icon Theme]\nDirectories=48x48/apps\n[48x48/apps]\nSize=48\nType=Threshold\n");
+    write(system / "hicolor/48x48/apps/terminal.png");
+    write(system / "hicolor/48x48/apps/editor.png");
+    write(pixmaps / "mail.xpm");
+
+    // a theme of the user adds icons to the theme of the system
+    write(user / "breeze/apps/16/browser.png");
+
+    const apptime::icon_theme theme{"breeze", {user, system, pixmaps}};
+    REQUIRE(theme.themes() == std::vector<std::string>{"breeze", "base", "hicolor"});
+
+    // the closest size, PNG is preferred to SVG of the same size
+    REQUIRE(theme.find("editor", 16) == system / "breeze/apps/16/editor.png");
+    REQUIRE(theme.find("editor", 22) == system / "breeze/apps/16/editor.png");
+    REQUIRE(theme.find("editor", 40) == system / "breeze/apps/48/editor.png");
+    REQUIRE(theme.find("editor", 128) == system / "breeze/apps/scalable/editor.svg");
+    REQUIRE(theme.find("viewer", 16) == system / "breeze/apps/scalable/viewer.svg");
+    REQUIRE(theme.find("browser", 48) == user / "breeze/apps/16/browser.png");
+
+    // inherited themes, hicolor and unthemed icons
+    REQUIRE(theme.find("player", 48) == system / "base/32x32/apps/player.png");
+    REQUIRE(theme.find("terminal.png", 48) == system / "hicolor/48x48/apps/terminal.png");
+    REQUIRE(theme.find("mail", 48) == pixmaps / "mail.xpm");
+    REQUIRE(theme.find((pixmaps / "mail.xpm").string(), 48) == pixmaps / "mail.xpm");
+    REQUIRE(theme.find("unknown", 48).empty());
+    REQUIRE(theme.find((pixmaps / "unknown.png").string(), 48).empty());
+
+    // an unknown theme falls back to hicolor
+    const apptime::icon_theme unknown{"unknown", {user, system, pixmaps}};
+    REQUIRE(unknown.themes() == std::vector<std::string>{"hicolor"});
+    REQUIRE(unknown.find("editor", 16) == system / "hicolor/48x48/apps/editor.png");
+}
+
+int main(int argc, char *argv[]) {
+    return Catch::Session().run(argc, argv);
+}
+
+// NOLINTEND(readability-function-cognitive-complexity, misc-use-anonymous-namespace, cppcoreguidelines-avoid-do-while)
\ No newline at end of file
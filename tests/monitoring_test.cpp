@@ -4,6 +4,7 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include "monitoring.hpp"
+#include "sampling.hpp"
 #include "utils.hpp"
 
 using namespace std::chrono_literals;
@@ -44,6 +45,52 @@ private:
     std::vector<apptime::ignore> ignores_;
 };
 
+// the writes of actives block until the gate is opened
+class database_gate_mock : public database_mock {
+public:
+    bool add_active(const apptime::record &rec) override {
+        std::unique_lock<std::mutex> lock{mutex_};
+        cv_.wait(lock, [this] {
+            return open_;
+        });
+        return database_mock::add_active(rec);
+    }
+
+    void open() {
+        {
+            const std::lock_guard<std::mutex> lock{mutex_};
+            open_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    bool                    open_ = false;
+};
+
+// records are journaled until the batch is added
+class database_journal_mock : public database_mock {
+public:
+    bool add_records(std::span<const apptime::record> actives, std::span<const apptime::record> focuses) override {
+        batches_++;
+        return database_mock::add_records(actives, focuses);
+    }
+
+    bool journal(std::span<const apptime::record> actives, std::span<const apptime::record> focuses) override {
+        journaled_ += actives.size() + focuses.size();
+        return true;
+    }
+
+    std::size_t batches() const { return batches_; }
+    std::size_t journaled() const { return journaled_; }
+
+private:
+    std::atomic<std::size_t> batches_   = 0;
+    std::atomic<std::size_t> journaled_ = 0;
+};
+
 class process_mock : public apptime::process {
 public:
     // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
@@ -79,6 +126,78 @@ public:
     process_type              focused_window() override { return std::make_unique<process_mock>(make_process()); }
 };
 
+// the focused window doesn't change, so every cycle writes the same interval
+class process_mgr_focus_mock : public process_mgr_mock {
+public:
+    process_type focused_window() override { return std::make_unique<process_mock>("test", "/dir/test", start_); }
+
+private:
+    std::chrono::system_clock::time_point start_ = std::chrono::system_clock::now();
+};
+
+class idle_detector_mock : public apptime::idle_detector {
+public:
+    void on_idle_change(idle_callback callback) override {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        callback_ = std::move(callback);
+    }
+
+    void change(bool idle, time_point since) {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        if (callback_) {
+            callback_(idle, since);
+        }
+    }
+
+private:
+    std::mutex    mutex_;
+    idle_callback callback_;
+};
+
+// two processes of one executable, every snapshot both of them consumed 100 ms of CPU time more
+class process_mgr_usage_mock : public process_mgr_mock {
+public:
+    static constexpr auto                  cpu_step = 100ms;
+    static constexpr std::uint64_t         rss      = 1000;
+    static constexpr apptime::exe_identity exe      = {.device = 2049, .inode = 1234, .mtime = 1};
+
+    void snapshot(bool /*only_visible*/, apptime::process_buffer &buffer) override {
+        buffer.clear();
+        samples_++;
+        for (int pid: {1, 2}) {
+            buffer.push_back(apptime::process_entry{
+                .pid         = pid,
+                .window_name = {},
+                .full_path   = "/dir/usage",
+                .exe_id      = 1,
+                .exe         = exe,
+                .start       = start_ + std::chrono::seconds{pid},
+                .cpu_time    = cpu_step * samples_,
+                .rss         = rss,
+            });
+        }
+    }
+
+private:
+    std::chrono::system_clock::time_point start_ = std::chrono::system_clock::now();
+    int                                   samples_ = 0;
+};
+
+// an application and its helper process with another executable
+class process_mgr_tree_mock : public process_mgr_mock {
+public:
+    static constexpr std::uint64_t rss = 1000;
+
+    void snapshot(bool /*only_visible*/, apptime::process_buffer &buffer) override {
+        buffer.clear();
+        buffer.push_back(apptime::process_entry{.pid = 1, .ppid = 0, .window_name = {}, .full_path = "/dir/app", .start = start_, .rss = rss});
+        buffer.push_back(apptime::process_entry{.pid = 2, .ppid = 1, .window_name = {}, .full_path = "/dir/helper", .start = start_ + 1s, .rss = rss});
+    }
+
+private:
+    std::chrono::system_clock::time_point start_ = std::chrono::system_clock::now();
+};
+
 TEST_CASE("monitoring") {
     auto                database = std::make_shared<database_mock>();
     apptime::monitoring monitoring{database, std::make_unique<process_mgr_mock>()};
@@ -142,6 +261,428 @@ TEST_CASE("monitoring") {
     }
 }
 
+TEST_CASE("monitoring resource usage") {
+    auto                database = std::make_shared<database_mock>();
+    apptime::monitoring monitoring{database, std::make_unique<process_mgr_usage_mock>()};
+
+    constexpr auto monitoring_delay = 10ms;
+    monitoring.active_delay         = monitoring_delay;
+    monitoring.focus_delay          = monitoring_delay;
+    monitoring.checkpoint_interval  = 0ms; // every sample is written
+    monitoring.start();
+
+    const std::size_t min_records = 3;
+    const timer       monitoring_timer{monitoring_delay * min_records * 10};
+    while (database->actives({}).size() < min_records && !monitoring_timer.expired()) {
+        constexpr auto delay = 1ms;
+        std::this_thread::sleep_for(delay);
+    }
+    monitoring.stop();
+
+    // one record per cycle, the usage of both processes is summed up and accumulated over the interval
+    const std::vector<apptime::record> actives = database->actives({});
+    REQUIRE(actives.size() >= min_records);
+    for (std::size_t i = 0; i < actives.size(); i++) {
+        const auto samples = static_cast<int>(i + 1);
+        REQUIRE(actives[i].exe_id == 1);
+        REQUIRE(actives[i].inode == process_mgr_usage_mock::exe.inode);
+        REQUIRE(actives[i].cpu_time == 2 * process_mgr_usage_mock::cpu_step * samples);
+        REQUIRE(actives[i].rss_peak == 2 * process_mgr_usage_mock::rss);
+        REQUIRE(actives[i].rss_avg == 2 * process_mgr_usage_mock::rss);
+    }
+}
+
+TEST_CASE("monitoring process tree") {
+    auto                database = std::make_shared<database_mock>();
+    apptime::monitoring monitoring{database, std::make_unique<process_mgr_tree_mock>()};
+
+    constexpr auto monitoring_delay = 10ms;
+    monitoring.active_delay         = monitoring_delay;
+    monitoring.focus_delay          = monitoring_delay;
+    monitoring.checkpoint_interval  = 0ms; // every sample is written
+    monitoring.tree_roots({"/dir/app"});
+    monitoring.start();
+
+    const std::size_t min_records = 2;
+    const timer       monitoring_timer{monitoring_delay * min_records * 10};
+    while (database->actives({}).size() < min_records && !monitoring_timer.expired()) {
+        constexpr auto delay = 1ms;
+        std::this_thread::sleep_for(delay);
+    }
+    monitoring.stop();
+
+    // the helper is written as a part of the application
+    const std::vector<apptime::record> actives = database->actives({});
+    REQUIRE(actives.size() >= min_records);
+    for (const auto &rec: actives) {
+        REQUIRE(rec.path == "/dir/app");
+        REQUIRE(rec.rss_peak == 2 * process_mgr_tree_mock::rss);
+    }
+}
+
+TEST_CASE("monitoring idle") {
+    auto                database = std::make_shared<database_mock>();
+    auto                idle     = std::make_unique<idle_detector_mock>();
+    idle_detector_mock *detector = idle.get();
+    apptime::monitoring monitoring{database, std::make_unique<process_mgr_focus_mock>(), std::move(idle)};
+
+    constexpr auto monitoring_delay = 10ms;
+    monitoring.active_delay         = 1h;
+    monitoring.focus_delay          = monitoring_delay;
+    monitoring.checkpoint_interval  = 0ms; // every sample is written
+    monitoring.start();
+
+    const auto wait_focuses = [&database](std::size_t count) {
+        const timer monitoring_timer{1s};
+        while (database->focuses({}).size() < count && !monitoring_timer.expired()) {
+            constexpr auto delay = 1ms;
+            std::this_thread::sleep_for(delay);
+        }
+        return database->focuses({}).size();
+    };
+    REQUIRE(wait_focuses(2) >= 2);
+
+    // the interval is closed at the last input, nothing is written while the user is away
+    const auto left = std::chrono::system_clock::now();
+    detector->change(true, left);
+    std::this_thread::sleep_for(monitoring_delay * 5);
+    const std::size_t written = database->focuses({}).size();
+    const auto        closed  = database->focuses({}).back();
+    REQUIRE(closed.times.back().second == std::max(closed.times.front().first, left));
+
+    std::this_thread::sleep_for(monitoring_delay * 5);
+    REQUIRE(database->focuses({}).size() == written);
+
+    // a new interval starts when the user is back, although the window was focused before
+    const auto back = std::chrono::system_clock::now();
+    detector->change(false, back);
+    REQUIRE(wait_focuses(written + 1) > written);
+    monitoring.stop();
+
+    const auto resumed = database->focuses({}).back();
+    REQUIRE(resumed.times.front().first == back);
+    REQUIRE(resumed.times.front().first > closed.times.front().first);
+}
+
+TEST_CASE("monitoring writer") {
+    auto                database = std::make_shared<database_gate_mock>();
+    apptime::monitoring monitoring{database, std::make_unique<process_mgr_mock>()};
+
+    constexpr auto monitoring_delay = 10ms;
+    monitoring.active_delay         = monitoring_delay;
+    monitoring.focus_delay          = monitoring_delay;
+    monitoring.checkpoint_interval  = 0ms; // every sample is written
+    monitoring.start();
+
+    // a slow write doesn't delay the samplers, their records wait in the queues
+    const std::size_t min_records = 3;
+    const timer       monitoring_timer{1s};
+    while (monitoring.stats().focus.depth < min_records && !monitoring_timer.expired()) {
+        constexpr auto delay = 1ms;
+        std::this_thread::sleep_for(delay);
+    }
+    REQUIRE(monitoring.stats().focus.depth >= min_records);
+    REQUIRE(monitoring.stats().active.depth >= 1);
+
+    // the writer writes the remaining records when monitoring stops
+    database->open();
+    monitoring.stop();
+    const apptime::monitoring::writer_stats stats = monitoring.stats();
+    REQUIRE(stats.active.depth == 0);
+    REQUIRE(stats.focus.depth == 0);
+    REQUIRE(stats.focus.capacity > 0);
+    REQUIRE(stats.active.dropped == 0);
+    REQUIRE(stats.focus.dropped == 0);
+    REQUIRE(database->focuses({}).size() >= min_records);
+}
+
+TEST_CASE("monitoring write-behind") {
+    auto                database = std::make_shared<database_journal_mock>();
+    apptime::monitoring monitoring{database, std::make_unique<process_mgr_focus_mock>()};
+
+    constexpr auto monitoring_delay = 10ms;
+    monitoring.active_delay         = monitoring_delay;
+    monitoring.focus_delay          = monitoring_delay;
+    monitoring.checkpoint_interval  = 0ms; // every sample is written
+    monitoring.flush_interval       = 1h;
+    monitoring.start();
+
+    // records are journaled and kept in memory until the flush
+    const std::size_t min_records = 5;
+    const timer       monitoring_timer{1s};
+    while (database->journaled() < min_records && !monitoring_timer.expired()) {
+        constexpr auto delay = 1ms;
+        std::this_thread::sleep_for(delay);
+    }
+    REQUIRE(database->journaled() >= min_records);
+    REQUIRE(database->batches() == 0);
+    REQUIRE(monitoring.stats().pending > 0);
+
+    // the batch is written by one call when monitoring stops, the focus interval pushed by every cycle is written once
+    monitoring.stop();
+    REQUIRE(database->batches() == 1);
+    REQUIRE(database->focuses({}).size() == 1);
+    REQUIRE(monitoring.stats().pending == 0);
+}
+
+TEST_CASE("monitoring sessions") {
+    // the usage mock with a focused window that doesn't change
+    class process_mgr_session_mock : public process_mgr_usage_mock {
+    public:
+        process_type focused_window() override { return std::make_unique<process_mock>("test", "/dir/test", start_); }
+
+    private:
+        std::chrono::system_clock::time_point start_ = std::chrono::system_clock::now();
+    };
+
+    auto                database = std::make_shared<database_mock>();
+    apptime::monitoring monitoring{database, std::make_unique<process_mgr_session_mock>()};
+
+    constexpr auto monitoring_delay = 10ms;
+    monitoring.active_delay         = monitoring_delay;
+    monitoring.focus_delay          = monitoring_delay;
+    monitoring.start();
+
+    // an open interval is written once, later samples are kept in memory until the checkpoint
+    std::this_thread::sleep_for(monitoring_delay * 10);
+    REQUIRE(database->actives({}).size() == 1);
+    REQUIRE(database->focuses({}).size() == 1);
+
+    // the intervals are written again when they close
+    monitoring.stop();
+    const std::vector<apptime::record> actives = database->actives({});
+    const std::vector<apptime::record> focuses = database->focuses({});
+    REQUIRE(actives.size() == 2);
+    REQUIRE(focuses.size() == 2);
+    REQUIRE(actives[1].times.front().first == actives[0].times.front().first);
+    REQUIRE(actives[1].times.front().second > actives[0].times.front().second);
+    REQUIRE(actives[1].cpu_time > actives[0].cpu_time);
+    REQUIRE(focuses[1].times.front().first == focuses[0].times.front().first);
+    REQUIRE(focuses[1].times.front().second > focuses[0].times.front().second);
+}
+
+TEST_CASE("monitoring adaptive") {
+    auto database = std::make_shared<database_mock>();
+
+    SECTION("back off") {
+        // the processes don't change, so the delay grows up to the ceiling
+        apptime::monitoring monitoring{database, std::make_unique<process_mgr_usage_mock>()};
+        monitoring.adaptive     = true;
+        monitoring.min_delay    = 1ms;
+        monitoring.active_delay = 64ms;
+        monitoring.focus_delay  = 64ms;
+        monitoring.start();
+
+        const timer monitoring_timer{1s};
+        while (monitoring.polling().active.delay != 64ms && !monitoring_timer.expired()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        REQUIRE(monitoring.polling().active.delay == 64ms);
+        monitoring.stop();
+    }
+
+    SECTION("changes") {
+        // every poll sees a new process and a new focused window, so the threads keep the minimum delay
+        apptime::monitoring monitoring{database, std::make_unique<process_mgr_mock>()};
+        monitoring.adaptive     = true;
+        monitoring.min_delay    = 5ms;
+        monitoring.active_delay = 1h;
+        monitoring.focus_delay  = 1h;
+        monitoring.start();
+
+        const timer monitoring_timer{1s};
+        while ((monitoring.polling().active.caught < 3 || monitoring.polling().focus.caught < 3) && !monitoring_timer.expired()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        monitoring.stop();
+
+        const apptime::monitoring::poll_stats stats = monitoring.polling();
+        REQUIRE(stats.active.delay == 5ms);
+        REQUIRE(stats.active.caught >= 3);
+        REQUIRE(stats.active.missed == 0);
+        REQUIRE(stats.focus.delay == 5ms);
+        REQUIRE(stats.focus.caught >= 3);
+        REQUIRE(stats.focus.missed == 0);
+    }
+}
+
+TEST_CASE("sampling filter") {
+    apptime::process_buffer buffer;
+    apptime::process_tree   tree;
+
+    SECTION("applications") {
+        // two processes of one executable, a process without an executable and an unknown executable
+        process_mgr_usage_mock{}.snapshot(true, buffer);
+        buffer.push_back(apptime::process_entry{.pid = 3, .window_name = {}, .full_path = {}, .start = {}, .rss = 1});
+        buffer.push_back(apptime::process_entry{.pid = 4, .window_name = {}, .full_path = "/dir/other", .start = {}, .cpu_time = 10ms, .rss = 1});
+
+        const auto processes = apptime::filter_windows(buffer, tree);
+        REQUIRE(processes.size() == 2);
+        REQUIRE(processes[0].full_path == "/dir/other");
+        REQUIRE(processes[0].cpu_time == 10ms);
+        REQUIRE(processes[1].full_path == "/dir/usage");
+        REQUIRE(processes[1].cpu_time == 2 * process_mgr_usage_mock::cpu_step);
+        REQUIRE(processes[1].rss == 2 * process_mgr_usage_mock::rss);
+    }
+
+    SECTION("helpers") {
+        process_mgr_tree_mock{}.snapshot(true, buffer);
+        REQUIRE(apptime::filter_windows(buffer, tree).size() == 2);
+
+        process_mgr_tree_mock{}.snapshot(true, buffer);
+        tree.roots({"/dir/app"});
+        const auto processes = apptime::filter_windows(buffer, tree);
+        REQUIRE(processes.size() == 1);
+        REQUIRE(processes[0].pid == 1);
+        REQUIRE(processes[0].rss == 2 * process_mgr_tree_mock::rss);
+    }
+}
+
+TEST_CASE("sampling records") {
+    const auto start = std::chrono::system_clock::now() - 1h;
+
+    // a reused record is overwritten
+    apptime::process_buffer buffer;
+    buffer.push_back(apptime::process_entry{.pid = 1, .window_name = "window", .full_path = "/dir/test", .exe_id = 1, .start = start});
+    apptime::record rec;
+    rec.times.emplace_back(start - 1h, start);
+    apptime::build_record(buffer.entries()[0], rec);
+    REQUIRE(rec.name == "window");
+    REQUIRE(rec.path == "/dir/test");
+    REQUIRE(rec.exe_id == 1);
+    REQUIRE(rec.times.size() == 1);
+    REQUIRE(rec.times.front().first == start);
+    REQUIRE(rec.times.front().second > start);
+
+    const apptime::record focused = apptime::build_record(std::make_unique<process_mock>("focus", "/dir/focus", start), true);
+    REQUIRE(focused.name == "focus");
+    REQUIRE(focused.path == "/dir/focus");
+    REQUIRE(focused.times.front().first == start);
+}
+
+TEST_CASE("scheduler") {
+    apptime::scheduler scheduler;
+    std::atomic<int>   periodic = 0;
+    std::atomic<int>   woken    = 0;
+    scheduler.add("periodic", [&periodic] {
+        periodic++;
+        std::this_thread::sleep_for(15ms);
+        return 20ms;
+    });
+    const std::size_t event = scheduler.add("event", [&woken] {
+        woken++;
+        return apptime::scheduler::never;
+    });
+    scheduler.start();
+
+    // the work of a run doesn't shift the deadlines: about 15 runs in 300 ms, not 300 / (20 + 15)
+    std::this_thread::sleep_for(300ms);
+    REQUIRE(periodic >= 11);
+    REQUIRE(woken == 1);
+
+    // a task without a deadline runs when it's woken
+    scheduler.wake(event);
+    const timer scheduler_timer{1s};
+    while (woken < 2 && !scheduler_timer.expired()) {
+        std::this_thread::sleep_for(1ms);
+    }
+    scheduler.stop();
+    REQUIRE(woken == 2);
+
+    const std::vector<apptime::scheduler::task_stats> stats = scheduler.stats();
+    REQUIRE(stats.size() == 2);
+    REQUIRE(stats[0].name == "periodic");
+    REQUIRE(stats[0].runs == static_cast<std::uint64_t>(periodic));
+    REQUIRE(stats[1].runs == 2);
+}
+
+TEST_CASE("scheduler lateness") {
+    // the tasks are due at once, the fast one waits for the slow one
+    apptime::scheduler scheduler;
+    scheduler.add("slow", [] {
+        std::this_thread::sleep_for(50ms);
+        return 1h;
+    });
+    scheduler.add("fast", [] {
+        return 10ms;
+    });
+    scheduler.start();
+    std::this_thread::sleep_for(100ms);
+    scheduler.stop();
+
+    const std::vector<apptime::scheduler::task_stats> stats = scheduler.stats();
+    REQUIRE(stats[0].max_late < 40ms);
+    REQUIRE(stats[1].max_late >= 40ms);
+    REQUIRE(stats[1].runs > 1);
+    REQUIRE(stats[1].total_late >= stats[1].max_late);
+}
+
+TEST_CASE("latency histogram") {
+    // every value up to 16 ns has its bucket, longer values are within 1/16 of their bucket
+    REQUIRE(apptime::latency_histogram::bucket(15) == 15);
+    REQUIRE(apptime::latency_histogram::bucket(16) == 16);
+    REQUIRE(apptime::latency_histogram::bucket(33) == apptime::latency_histogram::bucket(32));
+    REQUIRE(apptime::latency_histogram::bucket(34) == apptime::latency_histogram::bucket(32) + 1);
+    REQUIRE(apptime::latency_histogram::bucket_end(apptime::latency_histogram::bucket(1'000'000)) >= 1'000'000);
+    REQUIRE(apptime::latency_histogram::bucket_end(apptime::latency_histogram::bucket(1'000'000)) < 1'000'000 + 1'000'000 / 16);
+    REQUIRE(apptime::latency_histogram::bucket(std::uint64_t{1} << 39) < apptime::latency_histogram::bucket_count);
+
+    apptime::latency_histogram histogram;
+    REQUIRE(histogram.read().count == 0);
+    REQUIRE(histogram.read().percentile(99) == 0ns);
+
+    for (int i = 1; i <= 100; i++) {
+        histogram.record(std::chrono::microseconds{i});
+    }
+    histogram.record(24h);
+
+    const apptime::latency_histogram::snapshot values = histogram.read();
+    REQUIRE(values.count == 101);
+    REQUIRE(values.percentile(50) >= 50us);
+    REQUIRE(values.percentile(50) < 54us);
+    REQUIRE(values.percentile(99) >= 99us);
+    REQUIRE(values.percentile(99) < 106us);
+    // durations beyond the range are counted as the maximum
+    REQUIRE(values.max == std::chrono::nanoseconds{(std::int64_t{1} << apptime::latency_histogram::max_bits) - 1});
+    REQUIRE(values.percentile(100) == values.max);
+}
+
+TEST_CASE("monitoring latencies") {
+    auto                database = std::make_shared<database_mock>();
+    apptime::monitoring monitoring{database, std::make_unique<process_mgr_mock>()};
+    monitoring.active_delay   = 10ms;
+    monitoring.focus_delay    = 10ms;
+    monitoring.flush_interval = 0ms;
+    monitoring.start();
+
+    const auto  cycles = [&monitoring] {
+        return monitoring.latencies()[3].values.count;
+    };
+    const timer monitoring_timer{1s};
+    while (cycles() < 3 && !monitoring_timer.expired()) {
+        std::this_thread::sleep_for(1ms);
+    }
+    monitoring.stop();
+
+    // every cycle records its stages, the writer records the database writes
+    for (const auto &latency: monitoring.latencies()) {
+        INFO(latency.sampler << " " << latency.stage);
+        if (latency.stage == "journal") {
+            REQUIRE(latency.values.count == 0);
+            continue;
+        }
+        REQUIRE(latency.values.count > 0);
+        REQUIRE(latency.values.max >= latency.values.percentile(50));
+    }
+    const std::vector<apptime::monitoring::latency_stats> latencies = monitoring.latencies();
+    REQUIRE(latencies[0].sampler == "active");
+    REQUIRE(latencies[0].stage == "scan");
+    REQUIRE(latencies[3].stage == "cycle");
+    REQUIRE(latencies[3].values.count >= 3);
+    REQUIRE(latencies[2].values.count == 2 * latencies[3].values.count);
+    REQUIRE(latencies[3].values.total >= latencies[0].values.total + latencies[1].values.total);
+}
+
 int main(int argc, char *argv[]) {
     return Catch::Session().run(argc, argv);
 }
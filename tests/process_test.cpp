@@ -0,0 +1,630 @@
+// NOLINTBEGIN(readability-function-cognitive-complexity, misc-use-anonymous-namespace, cppcoreguidelines-avoid-do-while)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#endif
+
+#include <catch2/catch_session.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "process/exit_watcher.hpp"
+#include "process/process_buffer.hpp"
+#ifdef __linux__
+#include "process/process_events.hpp"
+#include "process/process_netlink.hpp"
+#endif
+#include "process/process_tree.hpp"
+#include "process/procfs_scanner.hpp"
+#include "procfs_tree.hpp"
+#include "utils.hpp"
+
+using namespace std::chrono_literals;
+
+// spawn a child process that waits for a signal
+int spawn_child() {
+    const int pid = fork();
+    if (pid == 0) {
+        pause();
+        _exit(0);
+    }
+    return pid;
+}
+
+TEST_CASE("exit watcher") {
+    std::atomic_int       exited_pid = -1;
+    apptime::exit_watcher watcher{[&exited_pid](int pid, std::chrono::system_clock::time_point /*exit_time*/) {
+        exited_pid = pid;
+    }};
+
+    const int pid = spawn_child();
+    REQUIRE(pid > 0);
+
+    SECTION("exit") {
+        REQUIRE(watcher.watch(pid));
+        REQUIRE(watcher.watching(pid));
+
+        kill(pid, SIGKILL);
+
+        const timer exit_timer{1s};
+        while (exited_pid != pid && !exit_timer.expired()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        REQUIRE(exited_pid == pid);
+        REQUIRE(!watcher.watching(pid));
+    }
+
+    SECTION("unwatch") {
+        REQUIRE(watcher.watch(pid));
+        watcher.unwatch(pid);
+        REQUIRE(!watcher.watching(pid));
+
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        std::this_thread::sleep_for(10ms);
+        REQUIRE(exited_pid == -1);
+    }
+
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+
+TEST_CASE("process buffer") {
+    apptime::process_buffer buffer;
+
+    SECTION("strings are copied") {
+        std::string path = "/usr/bin/app";
+        buffer.push_back(apptime::process_info{.pid = 1, .window_name = "window", .full_path = path, .start = {}});
+        path.clear();
+
+        REQUIRE(buffer.size() == 1);
+        REQUIRE(buffer.entries()[0].pid == 1);
+        REQUIRE(buffer.entries()[0].window_name == "window");
+        REQUIRE(buffer.entries()[0].full_path == "/usr/bin/app");
+    }
+
+    SECTION("memory is reused") {
+        const std::string long_path(apptime::process_buffer::block_size * 2, 'a');
+        buffer.store("short");
+        const char *data      = buffer.store(long_path).data();
+        const char *long_data = buffer.store(long_path).data();
+
+        buffer.clear();
+        REQUIRE(buffer.empty());
+        REQUIRE(buffer.store("short").data() != nullptr);
+        REQUIRE(buffer.store(long_path).data() == data);
+        REQUIRE(buffer.store(long_path).data() == long_data);
+    }
+}
+
+TEST_CASE("process tree") {
+    const auto start = std::chrono::system_clock::now();
+
+    apptime::process_buffer buffer;
+    const auto              add = [&buffer, start](int pid, int ppid, std::string_view path) {
+        buffer.push_back(apptime::process_entry{.pid = pid, .ppid = ppid, .window_name = {}, .full_path = path, .start = start + std::chrono::seconds{pid}});
+    };
+    add(1, 0, "/usr/lib/systemd/systemd");
+    add(10, 1, "/usr/bin/terminal");
+    add(11, 10, "/usr/bin/bash");
+    add(12, 11, "/usr/lib/firefox/firefox");
+    add(13, 12, "/usr/lib/firefox/crashhelper");
+    add(14, 12, "/usr/lib/firefox/firefox");
+    add(15, 14, "/usr/bin/helper");
+    add(20, 1, "/usr/bin/other");
+    add(30, 999, "/usr/bin/orphan");
+    add(40, 41, "/usr/bin/cycle");
+    add(41, 40, "/usr/bin/cycle");
+
+    apptime::process_tree tree;
+    tree.roots({"/usr/bin/terminal", "/usr/lib/firefox/"});
+    tree.fold(buffer);
+
+    const auto root_of = [&buffer](std::size_t index) {
+        return std::pair{buffer.entries()[index].pid, std::string{buffer.entries()[index].full_path}};
+    };
+    REQUIRE(root_of(0) == std::pair{1, std::string{"/usr/lib/systemd/systemd"}});
+    REQUIRE(root_of(1) == std::pair{10, std::string{"/usr/bin/terminal"}});
+    REQUIRE(root_of(2) == std::pair{10, std::string{"/usr/bin/terminal"}});
+
+    // an application launched from another root stays on its own, its helpers join it
+    for (std::size_t i = 3; i <= 6; i++) {
+        REQUIRE(root_of(i) == std::pair{12, std::string{"/usr/lib/firefox/firefox"}});
+        REQUIRE(buffer.entries()[i].start == start + std::chrono::seconds{12});
+    }
+
+    REQUIRE(root_of(7) == std::pair{20, std::string{"/usr/bin/other"}});
+    REQUIRE(root_of(8) == std::pair{30, std::string{"/usr/bin/orphan"}});
+    REQUIRE(root_of(9) == std::pair{40, std::string{"/usr/bin/cycle"}});
+    REQUIRE(root_of(10) == std::pair{41, std::string{"/usr/bin/cycle"}});
+}
+
+TEST_CASE("procfs scanner") {
+    constexpr int count = 100;
+
+    procfs_tree             tree{count, 1000};
+    apptime::procfs_scanner scanner{tree.root()};
+
+    SECTION("scan") {
+        const auto processes = scanner.scan();
+        REQUIRE(processes.size() == count);
+        REQUIRE(scanner.delta().spawned.size() == count);
+        REQUIRE(scanner.stats().resolved == count);
+
+        for (const auto &info: processes) {
+            REQUIRE(info.full_path == tree.exe(info.pid));
+            REQUIRE(info.ppid == 1);
+            const auto start = std::chrono::seconds{info.pid * 100 / sysconf(_SC_CLK_TCK)};
+            REQUIRE(info.start == std::chrono::system_clock::from_time_t(procfs_tree::boot_time) + start);
+        }
+    }
+
+    SECTION("only new processes are resolved") {
+        scanner.scan();
+        tree.add(5000, 500'000);
+        tree.remove(1000);
+
+        const auto processes = scanner.scan();
+        REQUIRE(processes.size() == count);
+        REQUIRE(scanner.stats().visited == count);
+        REQUIRE(scanner.stats().resolved == 1);
+        REQUIRE(scanner.delta().spawned.size() == 1);
+        REQUIRE(scanner.delta().spawned[0].pid == 5000);
+        REQUIRE(scanner.delta().exited.size() == 1);
+        REQUIRE(scanner.delta().exited[0].pid == 1000);
+    }
+
+    SECTION("zombies are skipped") {
+        tree.add(5000, 500'000, 'Z');
+        REQUIRE(scanner.scan().size() == count);
+    }
+
+    SECTION("buffer") {
+        apptime::process_buffer buffer;
+        scanner.scan(buffer);
+        REQUIRE(buffer.size() == count);
+
+        scanner.scan(std::array{1000}, buffer);
+        REQUIRE(buffer.size() == 1);
+        REQUIRE(buffer.entries()[0].full_path == tree.exe(1000));
+    }
+
+    SECTION("usage") {
+        const auto ticks_to_time = [](unsigned long long ticks) {
+            return std::chrono::milliseconds{ticks * 1000 / sysconf(_SC_CLK_TCK)};
+        };
+        const auto find = [](const std::vector<apptime::process_info> &processes, int pid) {
+            return *std::ranges::find(processes, pid, &apptime::process_info::pid);
+        };
+
+        // new processes get the usage from the read that resolves them
+        auto processes = scanner.scan();
+        REQUIRE(find(processes, 1000).cpu_time == ticks_to_time(25 + 10));
+        REQUIRE(find(processes, 1000).rss == 2048ULL * sysconf(_SC_PAGESIZE));
+
+        // known processes aren't read again without sampling
+        tree.write_stat(1000, 1000 * 100, 'S', 125, 4096);
+        REQUIRE(find(scanner.scan(), 1000).cpu_time == ticks_to_time(25 + 10));
+
+        scanner.usage(true);
+        processes = scanner.scan();
+        REQUIRE(processes.size() == count);
+        REQUIRE(scanner.stats().resolved == 0);
+        REQUIRE(find(processes, 1000).cpu_time == ticks_to_time(125 + 10));
+        REQUIRE(find(processes, 1000).rss == 4096ULL * sysconf(_SC_PAGESIZE));
+
+        // a reused process ID is reported as exited by the sampling scan and resolved again by the next one
+        tree.write_stat(1001, 900'000);
+        REQUIRE(scanner.scan().size() == count - 1);
+        REQUIRE(scanner.delta().exited.size() == 1);
+        REQUIRE(scanner.scan().size() == count);
+        REQUIRE(scanner.delta().spawned.size() == 1);
+
+        // processes collected by someone else
+        apptime::process_buffer buffer;
+        buffer.push_back(find(processes, 1000));
+        tree.write_stat(1000, 1000 * 100, 'S', 225);
+        scanner.sample(buffer.entries());
+        REQUIRE(buffer.entries()[0].cpu_time == ticks_to_time(225 + 10));
+    }
+
+    SECTION("executables") {
+        const auto find = [](const std::vector<apptime::process_info> &processes, int pid) {
+            return *std::ranges::find(processes, pid, &apptime::process_info::pid);
+        };
+
+        scanner.scan();
+        REQUIRE(scanner.exes().size() == count);
+
+        // processes of the same executable share its id, a known executable isn't read by readlink (the walk, stat and the identity of exe)
+        tree.add(5000, 500'000);
+        auto processes = scanner.scan();
+        REQUIRE(scanner.stats().syscalls == 5);
+        REQUIRE(find(processes, 5000).exe_id != 0);
+        REQUIRE(find(processes, 5000).exe_id == find(processes, 1000).exe_id);
+
+        // a renamed executable keeps its path
+        tree.add(5001, 500'100);
+        std::filesystem::rename(tree.exe(1001), tree.exe(1001) + "-renamed");
+        tree.link_exe(5001, tree.exe(1001) + "-renamed");
+
+        // an upgraded executable is another file, but it's the same application
+        procfs_tree::upgrade_exe(tree.exe(1002));
+        tree.add(5002, 500'200);
+
+        processes = scanner.scan();
+        REQUIRE(find(processes, 5001).full_path == tree.exe(1001));
+        REQUIRE(find(processes, 5001).exe_id == find(processes, 1001).exe_id);
+        REQUIRE(find(processes, 5002).exe != find(processes, 1002).exe);
+        REQUIRE(find(processes, 5002).exe_id == find(processes, 1002).exe_id);
+        REQUIRE(scanner.exes().size() == count + 1);
+    }
+
+    SECTION("given processes") {
+        const std::array pids{1000, 1001, 9999};
+        const auto       processes = scanner.scan(pids);
+        REQUIRE(processes.size() == 2);
+        REQUIRE(processes[0].pid == 1000);
+        REQUIRE(processes[1].pid == 1001);
+    }
+}
+
+TEST_CASE("procfs stat") {
+    apptime::procfs_stat stat;
+    REQUIRE(apptime::parse_procfs_stat("42 (a (b) c) R 1 42 42 0 -1 4194304 1000 0 0 0 250 100 0 0 20 0 1 0 12345 123456789 512\n", stat));
+    REQUIRE(stat.state == 'R');
+    REQUIRE(stat.ppid == 1);
+    REQUIRE(stat.utime == 250);
+    REQUIRE(stat.stime == 100);
+    REQUIRE(stat.start_ticks == 12345);
+    REQUIRE(stat.rss == 512);
+
+    // the content can be cut after the start time
+    REQUIRE(apptime::parse_procfs_stat("42 (a) S 1 42 42 0 -1 4194304 1000 0 0 0 250 100 0 0 20 0 1 0 12345", stat));
+    REQUIRE_FALSE(apptime::parse_procfs_stat("42 (a) S 1 42 42 0 -1 4194304 1000 0 0 0 250 100 0 0 20", stat));
+}
+
+TEST_CASE("procfs scanner workers") {
+    constexpr int count = 1000;
+
+    const procfs_tree       tree{count};
+    apptime::procfs_scanner serial{tree.root()};
+    apptime::procfs_scanner parallel{tree.root()};
+    serial.io_uring(false);
+    parallel.io_uring(false);
+    parallel.workers(4);
+
+    auto expected = serial.scan();
+    auto actual   = parallel.scan();
+    REQUIRE(parallel.stats().resolved == count);
+    REQUIRE(parallel.stats().syscalls == serial.stats().syscalls);
+
+    const auto by_pid = [](const apptime::process_info &lhs, const apptime::process_info &rhs) {
+        return lhs.pid < rhs.pid;
+    };
+    std::ranges::sort(expected, by_pid);
+    std::ranges::sort(actual, by_pid);
+    REQUIRE(actual.size() == expected.size());
+    for (std::size_t i = 0; i < actual.size(); i++) {
+        REQUIRE(actual[i].pid == expected[i].pid);
+        REQUIRE(actual[i].full_path == expected[i].full_path);
+        REQUIRE(actual[i].start == expected[i].start);
+    }
+}
+
+TEST_CASE("procfs scanner scope") {
+    procfs_tree tree{4, 1000};
+    tree.move(1000, "/user.slice/user-1000.slice/app-1.scope");
+    tree.move(1001, "/user.slice/user-1000.slice");
+    tree.move(1002, "/user.slice/user-1001.slice");
+    tree.move(1003, "/system.slice");
+
+    apptime::procfs_scanner scanner{tree.root(), tree.cgroup_root()};
+    const auto              pids = [](const std::vector<apptime::process_info> &processes) {
+        std::vector<int> result;
+        for (const auto &process: processes) {
+            result.push_back(process.pid);
+        }
+        std::ranges::sort(result);
+        return result;
+    };
+
+    SECTION("current user") {
+        // the synthetic tree is owned by the user that runs the tests
+        scanner.scope({.current_user = true, .cgroup = {}});
+        REQUIRE(scanner.scan().size() == 4);
+    }
+
+    SECTION("cgroup") {
+        scanner.scope({.cgroup = "/user.slice/user-1000.slice"});
+        REQUIRE(pids(scanner.scan()) == std::vector{1000, 1001});
+
+        const std::array given{1000, 1002, 1003};
+        REQUIRE(pids(scanner.scan(given)) == std::vector{1000});
+
+        apptime::process_info info;
+        REQUIRE(scanner.resolve(1001, info));
+        REQUIRE_FALSE(scanner.resolve(1003, info));
+    }
+
+    SECTION("changed") {
+        scanner.scope({.cgroup = "/system.slice"});
+        REQUIRE(pids(scanner.scan()) == std::vector{1003});
+
+        // processes out of the scope aren't reported as exited
+        tree.remove(1002);
+        scanner.scan();
+        REQUIRE(scanner.delta().exited.empty());
+
+        scanner.scope({});
+        REQUIRE(pids(scanner.scan()) == std::vector{1000, 1001, 1003});
+    }
+}
+
+TEST_CASE("procfs scanner reused pid") {
+    constexpr std::size_t count = 4;
+    procfs_tree           tree{count, 1000};
+    tree.move(1003, "/app.scope");
+
+    apptime::procfs_scanner scanner{tree.root(), tree.cgroup_root()};
+    scanner.scan();
+
+    SECTION("walk") {
+        // usage isn't sampled, the reused process ID is found by the inode of its directory
+        tree.reuse(1001, 900'000);
+        REQUIRE(scanner.scan().size() == count);
+        REQUIRE(scanner.stats().resolved == 1);
+        REQUIRE(scanner.delta().exited.size() == 1);
+        REQUIRE(scanner.delta().spawned.size() == 1);
+        REQUIRE(scanner.delta().spawned[0].start > scanner.delta().exited[0].start);
+
+        // a new inode of the same process isn't a change
+        tree.reuse(1000, 1000 * 100);
+        REQUIRE(scanner.scan().size() == count);
+        REQUIRE(scanner.stats().resolved == 1);
+        REQUIRE(scanner.delta().exited.empty());
+        REQUIRE(scanner.delta().spawned.empty());
+    }
+
+    SECTION("given") {
+        tree.reuse(1002, 900'000);
+        const std::array given{1002};
+        REQUIRE(scanner.scan(given).size() == 1);
+        REQUIRE(scanner.delta().spawned.size() == 1);
+        REQUIRE(scanner.delta().spawned[0].pid == 1002);
+        REQUIRE(std::ranges::count(scanner.delta().exited, 1002, &apptime::process_info::pid) == 1);
+    }
+
+    SECTION("cgroup") {
+        scanner.scope({.cgroup = "/app.scope"});
+        REQUIRE(scanner.scan().size() == 1);
+
+        tree.reuse(1003, 900'000);
+        tree.move(1003, "/app.scope");
+        REQUIRE(scanner.scan().size() == 1);
+        REQUIRE(scanner.delta().exited.size() == 1);
+        REQUIRE(scanner.delta().spawned.size() == 1);
+    }
+}
+
+#ifdef __linux__
+TEST_CASE("procfs scanner io_uring") {
+    constexpr int count = 1000;
+
+    const procfs_tree       tree{count};
+    apptime::procfs_scanner plain{tree.root()};
+    apptime::procfs_scanner batched{tree.root()};
+    plain.io_uring(false);
+
+    const auto expected = plain.scan();
+    const auto actual   = batched.scan();
+    if (!batched.io_uring()) {
+        SKIP("io_uring isn't available");
+    }
+
+    // one io_uring_enter per batch instead of open, read and close per process
+    REQUIRE(actual.size() == expected.size());
+    REQUIRE(batched.stats().syscalls < plain.stats().syscalls);
+    for (std::size_t i = 0; i < actual.size(); i++) {
+        REQUIRE(actual[i].pid == expected[i].pid);
+        REQUIRE(actual[i].full_path == expected[i].full_path);
+        REQUIRE(actual[i].start == expected[i].start);
+    }
+}
+
+// a datagram of the netlink process connector with a message per event
+class proc_datagram {
+public:
+    proc_datagram &fork(int pid, int tgid) {
+        proc_event event                 = {};
+        event.what                       = proc_event::PROC_EVENT_FORK;
+        event.event_data.fork.child_pid  = pid;
+        event.event_data.fork.child_tgid = tgid;
+        return append(event);
+    }
+
+    proc_datagram &exec(int pid) {
+        proc_event event                   = {};
+        event.what                         = proc_event::PROC_EVENT_EXEC;
+        event.event_data.exec.process_pid  = pid;
+        event.event_data.exec.process_tgid = pid;
+        return append(event);
+    }
+
+    proc_datagram &exit(int pid, int tgid) {
+        proc_event event                   = {};
+        event.what                         = proc_event::PROC_EVENT_EXIT;
+        event.event_data.exit.process_pid  = pid;
+        event.event_data.exit.process_tgid = tgid;
+        return append(event);
+    }
+
+    // a message of another type or connector, it must be skipped
+    proc_datagram &append(const proc_event &event, __u16 type = NLMSG_DONE, __u32 idx = CN_IDX_PROC) {
+        const std::size_t offset = data_.size();
+        data_.resize(offset + NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_event)));
+
+        nlmsghdr header   = {};
+        header.nlmsg_len  = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_event));
+        header.nlmsg_type = type;
+        cn_msg message    = {};
+        message.id.idx    = idx;
+        message.id.val    = CN_VAL_PROC;
+        message.len       = sizeof(proc_event);
+
+        std::memcpy(data_.data() + offset, &header, sizeof(header));
+        std::memcpy(data_.data() + offset + NLMSG_HDRLEN, &message, sizeof(message));
+        std::memcpy(data_.data() + offset + NLMSG_HDRLEN + sizeof(cn_msg), &event, sizeof(event));
+        return *this;
+    }
+
+    const char *data() const { return data_.data(); }
+    std::size_t size() const { return data_.size(); }
+
+private:
+    std::vector<char> data_;
+};
+
+std::vector<int> table_pids(const apptime::process_events &events) {
+    std::vector<int> result;
+    events.read([&result](const auto &table) {
+        for (const auto &[pid, info]: table) {
+            result.push_back(pid);
+        }
+    });
+    std::ranges::sort(result);
+    return result;
+}
+
+TEST_CASE("process events") {
+    procfs_tree             tree{4, 1000};
+    apptime::procfs_scanner scanner{tree.root()};
+    apptime::process_events events{scanner};
+    events.resync();
+    REQUIRE(table_pids(events) == std::vector{1000, 1001, 1002, 1003});
+
+    SECTION("fork and exit") {
+        tree.add(1004, 900'000);
+        tree.remove(1001);
+        const auto datagram = proc_datagram{}.fork(1004, 1004).exit(1001, 1001);
+        events.handle(datagram.data(), datagram.size());
+        REQUIRE(table_pids(events) == std::vector{1000, 1002, 1003, 1004});
+
+        std::string path;
+        events.read([&path](const auto &table) { path = table.at(1004).full_path; });
+        REQUIRE(path == tree.exe(1004));
+    }
+
+    SECTION("exec") {
+        // the executable is resolved again, a process that can't be resolved is removed
+        const std::string exe = (tree.root() / "bin" / "other").string();
+        tree.link_exe(1002, exe);
+        tree.remove(1003);
+        const auto datagram = proc_datagram{}.exec(1002).exec(1003);
+        events.handle(datagram.data(), datagram.size());
+        REQUIRE(table_pids(events) == std::vector{1000, 1001, 1002});
+
+        std::string path;
+        events.read([&path](const auto &table) { path = table.at(1002).full_path; });
+        REQUIRE(path == exe);
+    }
+
+    SECTION("threads") {
+        tree.add(1004, 900'000);
+        const auto datagram = proc_datagram{}.fork(1004, 1000).exit(1003, 1002);
+        events.handle(datagram.data(), datagram.size());
+        REQUIRE(table_pids(events) == std::vector{1000, 1001, 1002, 1003});
+    }
+
+    SECTION("skipped messages") {
+        proc_event exit                   = {};
+        exit.what                         = proc_event::PROC_EVENT_EXIT;
+        exit.event_data.exit.process_pid  = 1000;
+        exit.event_data.exit.process_tgid = 1000;
+
+        auto datagram = proc_datagram{}.append(exit, NLMSG_NOOP).append(exit, NLMSG_ERROR).append(exit, NLMSG_DONE, CN_IDX_PROC + 1);
+        events.handle(datagram.data(), datagram.size());
+        REQUIRE(table_pids(events) == std::vector{1000, 1001, 1002, 1003});
+
+        // a truncated message is dropped
+        datagram = proc_datagram{}.exit(1000, 1000);
+        events.handle(datagram.data(), NLMSG_HDRLEN - 1);
+        REQUIRE(table_pids(events) == std::vector{1000, 1001, 1002, 1003});
+    }
+
+    SECTION("lost events") {
+        tree.add(1004, 900'000);
+        tree.remove(1000);
+        events.receive_failed(EINTR);
+        REQUIRE(table_pids(events) == std::vector{1000, 1001, 1002, 1003});
+
+        events.receive_failed(ENOBUFS);
+        REQUIRE(table_pids(events) == std::vector{1001, 1002, 1003, 1004});
+    }
+}
+
+TEST_CASE("process netlink manager") {
+    procfs_tree tree{4, 1000};
+    const auto  pids = [](const std::vector<apptime::process_info> &processes) {
+        std::vector<int> result;
+        for (const auto &process: processes) {
+            result.push_back(process.pid);
+        }
+        std::ranges::sort(result);
+        return result;
+    };
+
+    SECTION("polling") {
+        // the connector can't be opened, so the manager scans procfs like process_system_mgr
+        apptime::process_netlink_mgr netlink{-1, tree.root()};
+        apptime::process_system_mgr  polling{tree.root()};
+        REQUIRE(!netlink.listening());
+        REQUIRE(pids(netlink.snapshot(false)) == pids(polling.snapshot(false)));
+
+        tree.add(1004, 900'000);
+        REQUIRE(pids(netlink.snapshot(false)) == pids(polling.snapshot(false)));
+    }
+
+    SECTION("events") {
+        // a socket pair stands in for the connector socket
+        std::array<int, 2> fds = {};
+        REQUIRE(socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, fds.data()) == 0);
+        {
+            apptime::process_netlink_mgr netlink{fds[0], tree.root()};
+            REQUIRE(netlink.listening());
+            REQUIRE(netlink.active_processes().size() == 4);
+
+            tree.add(1004, 900'000);
+            tree.add(1005, 900'000);
+            const auto datagram = proc_datagram{}.fork(1004, 1004).fork(1005, 1005).exit(1000, 1000);
+            REQUIRE(send(fds[1], datagram.data(), datagram.size(), 0) == static_cast<ssize_t>(datagram.size()));
+
+            // the table is updated by the listener thread
+            const timer event_timer{1s};
+            while (netlink.active_processes().size() != 5 && !event_timer.expired()) {
+                std::this_thread::sleep_for(1ms);
+            }
+            REQUIRE(netlink.active_processes().size() == 5);
+        }
+        close(fds[1]);
+    }
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    return Catch::Session().run(argc, argv);
+}
+
+// NOLINTEND(readability-function-cognitive-complexity, misc-use-anonymous-namespace, cppcoreguidelines-avoid-do-while)
\ No newline at end of file
@@ -0,0 +1,97 @@
+// NOLINTBEGIN(readability-function-cognitive-complexity, misc-use-anonymous-namespace, cppcoreguidelines-avoid-do-while)
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_session.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "process/process_system.hpp"
+#include "process/procfs_scanner.hpp"
+#include "procfs_tree.hpp"
+
+// the benchmarks are hidden, run them with: procfs-benchmark "[benchmark]"
+TEST_CASE("procfs scanner", "[.][benchmark]") {
+    const int count = GENERATE(1'000, 10'000, 100'000);
+
+    const procfs_tree tree{count};
+
+    // the cost of one scan in system calls
+    apptime::procfs_scanner scanner{tree.root()};
+    scanner.io_uring(false);
+    scanner.scan();
+    const apptime::procfs_scan_stats cold = scanner.stats();
+    scanner.scan();
+    const apptime::procfs_scan_stats warm = scanner.stats();
+    REQUIRE(cold.visited == static_cast<std::uint64_t>(count));
+    WARN(count << " processes: " << cold.syscalls << " syscalls for the first scan, " << warm.syscalls << " syscalls for the next ones");
+
+    apptime::procfs_scanner batched{tree.root()};
+    batched.scan();
+    WARN(count << " processes: " << batched.stats().syscalls << " syscalls for the first scan with io_uring"
+               << (batched.io_uring() ? "" : " (not available)"));
+
+    BENCHMARK("first scan of " + std::to_string(count) + " processes") {
+        apptime::procfs_scanner first{tree.root()};
+        first.io_uring(false);
+        return first.scan().size();
+    };
+
+    BENCHMARK("first scan of " + std::to_string(count) + " processes with 4 workers") {
+        apptime::procfs_scanner first{tree.root()};
+        first.io_uring(false);
+        first.workers(4);
+        return first.scan().size();
+    };
+
+    BENCHMARK("first scan of " + std::to_string(count) + " processes with io_uring") {
+        apptime::procfs_scanner first{tree.root()};
+        return first.scan().size();
+    };
+
+    BENCHMARK("next scan of " + std::to_string(count) + " processes") {
+        return scanner.scan().size();
+    };
+
+    // sampling CPU time and memory reads stat of every known process again
+    apptime::procfs_scanner sampled{tree.root()};
+    sampled.usage(true);
+    sampled.scan();
+    sampled.scan();
+    WARN(count << " processes: " << sampled.stats().syscalls << " syscalls for the next scans with usage sampling"
+               << (sampled.io_uring() ? " through io_uring" : ""));
+
+    BENCHMARK("next scan of " + std::to_string(count) + " processes with usage sampling") {
+        return sampled.scan().size();
+    };
+}
+
+// the scanner against procps on the processes of this system
+TEST_CASE("procfs scanner on /proc", "[.][benchmark]") {
+    apptime::process_system_mgr manager;
+
+    BENCHMARK("procps active_processes with full_path and start") {
+        std::size_t result = 0;
+        for (const auto &proc: manager.active_processes()) {
+            result += proc->full_path().size();
+            result += proc->start() != std::chrono::system_clock::time_point{};
+        }
+        return result;
+    };
+
+    BENCHMARK("first scan") {
+        apptime::procfs_scanner first;
+        first.io_uring(false);
+        return first.scan().size();
+    };
+
+    BENCHMARK("first scan with io_uring") {
+        apptime::procfs_scanner first;
+        return first.scan().size();
+    };
+}
+
+int main(int argc, char *argv[]) {
+    return Catch::Session().run(argc, argv);
+}
+
+// NOLINTEND(readability-function-cognitive-complexity, misc-use-anonymous-namespace, cppcoreguidelines-avoid-do-while)
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef TESTS_PROCFS_TREE_HPP
+#define TESTS_PROCFS_TREE_HPP
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+
+#include "utils.hpp"
+
+// a synthetic procfs tree in a temporary directory for the scanner tests and benchmarks:
+// <root>/stat with btime, <root>/<pid>/stat and <root>/<pid>/exe as a symbolic link to an empty executable in <root>/bin,
+// a cgroup v2 hierarchy is in <root>/cgroup where processes are placed with `move`
+class procfs_tree {
+public:
+    static constexpr std::time_t boot_time = 1'700'000'000;
+
+    explicit procfs_tree(int count, int first_pid = 1) : root_{std::filesystem::temp_directory_path() / ("apptime-procfs-" + random_string(8))} {
+        std::filesystem::create_directories(root_ / "bin");
+        std::ofstream{root_ / "stat"} << std::format("cpu  1 2 3 4\nbtime {}\nprocesses {}\n", boot_time, count);
+
+        for (int pid = first_pid; pid < first_pid + count; pid++) {
+            add(pid, static_cast<unsigned long long>(pid) * 100);
+        }
+    }
+
+    ~procfs_tree() {
+        std::error_code ec;
+        std::filesystem::remove_all(root_, ec);
+    }
+
+    procfs_tree(const procfs_tree &)            = delete;
+    procfs_tree &operator=(const procfs_tree &) = delete;
+
+    const std::filesystem::path &root() const { return root_; }
+    std::filesystem::path        cgroup_root() const { return root_ / "cgroup"; }
+
+    std::string exe(int pid) const { return (root_ / "bin" / std::format("app-{}", pid % 100)).string(); }
+
+    void add(int pid, unsigned long long start_ticks, char state = 'S') {
+        const std::filesystem::path dir = root_ / std::to_string(pid);
+        std::filesystem::create_directory(dir);
+        write_stat(pid, start_ticks, state);
+        link_exe(pid, exe(pid));
+    }
+
+    // point exe of a process to an executable, it's created if it doesn't exist
+    void link_exe(int pid, const std::string &exe) {
+        if (!std::filesystem::exists(exe)) {
+            std::ofstream{exe};
+        }
+        const std::filesystem::path link = root_ / std::to_string(pid) / "exe";
+        std::filesystem::remove(link);
+        std::filesystem::create_symlink(exe, link);
+    }
+
+    // replace an executable by a new file with the same path like a package manager does, so it gets another inode
+    static void upgrade_exe(const std::string &exe) {
+        std::ofstream{exe + ".new"} << "upgraded";
+        std::filesystem::rename(exe + ".new", exe);
+    }
+
+    // fields 3-24 of proc(5) with the user time, the start time and the resident set size in pages, the rest are cut
+    void write_stat(int pid, unsigned long long start_ticks, char state = 'S', unsigned long long utime = 25, long long rss = 2048) {
+        std::ofstream{root_ / std::to_string(pid) / "stat"} << std::format("{} (app {}) {} 1 {} {} 0 -1 4194304 1000 0 0 0 {} 10 0 0 20 0 1 0 {} 123456789 {}\n",
+                                                                           pid, pid, state, pid, pid, utime, start_ticks, rss);
+    }
+
+    // replace a process by another one with the same ID, the old directory is removed last, so the new one gets another inode like in procfs
+    void reuse(int pid, unsigned long long start_ticks) {
+        const std::filesystem::path old = root_ / std::format("{}.old", pid);
+        std::filesystem::rename(root_ / std::to_string(pid), old);
+        add(pid, start_ticks);
+        std::filesystem::remove_all(old);
+    }
+
+    void remove(int pid) { std::filesystem::remove_all(root_ / std::to_string(pid)); }
+
+    // place a process into a cgroup, e.g. "/user.slice/app.scope"
+    void move(int pid, const std::string &cgroup) {
+        const std::filesystem::path dir = cgroup_root() / std::filesystem::path{cgroup}.relative_path();
+        std::filesystem::create_directories(dir);
+        std::ofstream{dir / "cgroup.procs", std::ios::app} << pid << '\n';
+        std::ofstream{root_ / std::to_string(pid) / "cgroup"} << "0::" << cgroup << '\n';
+    }
+
+private:
+    std::filesystem::path root_;
+};
+
+#endif // TESTS_PROCFS_TREE_HPP
\ No newline at end of file
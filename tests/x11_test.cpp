@@ -0,0 +1,183 @@
+// NOLINTBEGIN(readability-function-cognitive-complexity, misc-use-anonymous-namespace, cppcoreguidelines-avoid-do-while)
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+#include <xcb/xcb.h>
+
+#include <catch2/catch_session.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "process/x11_session.hpp"
+#include "utils.hpp"
+
+using namespace std::chrono_literals;
+
+// a window manager stub: creates client windows and sets EWMH properties of the root window
+class window_manager {
+public:
+    window_manager() : connection_{xcb_connect(nullptr, nullptr)} {
+        if (xcb_connection_has_error(connection_)) {
+            return;
+        }
+        root_ = xcb_setup_roots_iterator(xcb_get_setup(connection_)).data->root;
+
+        net_active_window_ = atom("_NET_ACTIVE_WINDOW");
+        net_client_list_   = atom("_NET_CLIENT_LIST");
+        net_wm_pid_        = atom("_NET_WM_PID");
+        net_wm_name_       = atom("_NET_WM_NAME");
+        utf8_string_       = atom("UTF8_STRING");
+    }
+
+    ~window_manager() { xcb_disconnect(connection_); }
+
+    bool connected() const { return !xcb_connection_has_error(connection_); }
+
+    xcb_window_t create_window(std::uint32_t pid, std::string_view name = {}) {
+        const xcb_window_t window = xcb_generate_id(connection_);
+        xcb_create_window(connection_, XCB_COPY_FROM_PARENT, window, root_, 0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0,
+                          nullptr);
+        xcb_change_property(connection_, XCB_PROP_MODE_REPLACE, window, net_wm_pid_, XCB_ATOM_CARDINAL, 32, 1, &pid);
+        xcb_change_property(connection_, XCB_PROP_MODE_REPLACE, window, net_wm_name_, utf8_string_, 8, static_cast<std::uint32_t>(name.size()),
+                            name.data());
+        xcb_map_window(connection_, window);
+        xcb_flush(connection_);
+        return window;
+    }
+
+    void set_name(xcb_window_t window, std::string_view name) {
+        xcb_change_property(connection_, XCB_PROP_MODE_REPLACE, window, net_wm_name_, utf8_string_, 8, static_cast<std::uint32_t>(name.size()),
+                            name.data());
+        xcb_flush(connection_);
+    }
+
+    void set_clients(const std::vector<xcb_window_t> &windows) {
+        xcb_change_property(connection_, XCB_PROP_MODE_REPLACE, root_, net_client_list_, XCB_ATOM_WINDOW, 32, static_cast<std::uint32_t>(windows.size()),
+                            windows.data());
+        xcb_flush(connection_);
+    }
+
+    void sync() { free(xcb_get_input_focus_reply(connection_, xcb_get_input_focus(connection_), nullptr)); } // NOLINT(cppcoreguidelines-no-malloc)
+
+    void activate(xcb_window_t window) {
+        xcb_change_property(connection_, XCB_PROP_MODE_REPLACE, root_, net_active_window_, XCB_ATOM_WINDOW, 32, 1, &window);
+        xcb_flush(connection_);
+    }
+
+private:
+    xcb_atom_t atom(std::string_view name) {
+        const auto cookie = xcb_intern_atom(connection_, 0, static_cast<std::uint16_t>(name.size()), name.data());
+        auto      *reply  = xcb_intern_atom_reply(connection_, cookie, nullptr);
+        if (!reply) {
+            return XCB_ATOM_NONE;
+        }
+        const xcb_atom_t result = reply->atom;
+        free(reply); // NOLINT(cppcoreguidelines-no-malloc)
+        return result;
+    }
+
+    xcb_connection_t *connection_;
+    xcb_window_t      root_              = 0;
+    xcb_atom_t        net_active_window_ = XCB_ATOM_NONE;
+    xcb_atom_t        net_client_list_   = XCB_ATOM_NONE;
+    xcb_atom_t        net_wm_pid_        = XCB_ATOM_NONE;
+    xcb_atom_t        net_wm_name_       = XCB_ATOM_NONE;
+    xcb_atom_t        utf8_string_       = XCB_ATOM_NONE;
+};
+
+// run under a headless server, e.g. xvfb-run ctest
+TEST_CASE("x11 session") {
+    window_manager manager;
+    if (!manager.connected()) {
+        SKIP("no X11 server");
+    }
+
+    const auto session = apptime::x11_session::connect();
+    REQUIRE(session);
+
+    std::atomic_int changes = 0;
+    session->on_focus_change([&changes] {
+        changes++;
+    });
+
+    SECTION("focus change") {
+        const auto         pid    = static_cast<std::uint32_t>(getpid());
+        const xcb_window_t window = manager.create_window(pid);
+
+        const auto before = std::chrono::system_clock::now();
+        manager.activate(window);
+
+        const timer focus_timer{1s};
+        while (changes == 0 && !focus_timer.expired()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        REQUIRE(changes == 1);
+
+        const apptime::x11_session::focus focus = session->focused();
+        REQUIRE(focus.window == window);
+        REQUIRE(focus.pid == static_cast<int>(pid));
+        REQUIRE(focus.since >= before);
+
+        // the same window doesn't change the focus
+        manager.activate(window);
+        std::this_thread::sleep_for(50ms);
+        REQUIRE(changes == 1);
+    }
+
+    SECTION("client windows") {
+        const auto         pid    = static_cast<std::uint32_t>(getpid());
+        const xcb_window_t first  = manager.create_window(pid, "first");
+        const xcb_window_t second = manager.create_window(pid, "second");
+        const xcb_window_t other  = manager.create_window(pid + 1, "other");
+        manager.set_clients({first, second, other});
+        manager.sync();
+
+        const auto windows = session->windows(false);
+        REQUIRE(windows.size() == 3);
+        REQUIRE(windows[0].id == first);
+        REQUIRE(windows[0].pid == static_cast<int>(pid));
+        REQUIRE(windows[0].name == "first");
+
+        // one window per process
+        const auto process_windows = session->process_windows(false);
+        REQUIRE(process_windows.size() == 2);
+        REQUIRE(process_windows[0].name == "first");
+        REQUIRE(process_windows[1].name == "other");
+    }
+
+    SECTION("name version") {
+        const xcb_window_t window = manager.create_window(static_cast<std::uint32_t>(getpid()), "first");
+        manager.set_clients({window});
+        manager.sync();
+
+        const auto first = session->windows(false);
+        REQUIRE(first.size() == 1);
+        REQUIRE(first[0].name_version != 0);
+
+        // an unchanged name keeps its version
+        REQUIRE(session->windows(false).at(0).name_version == first[0].name_version);
+
+        // the name is read again after the event thread receives the property change
+        manager.set_name(window, "renamed");
+        manager.sync();
+        const timer name_timer{1s};
+        auto        renamed = session->windows(false);
+        while (renamed.at(0).name != "renamed" && !name_timer.expired()) {
+            std::this_thread::sleep_for(1ms);
+            renamed = session->windows(false);
+        }
+        REQUIRE(renamed.at(0).name == "renamed");
+        REQUIRE(renamed.at(0).name_version > first[0].name_version);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    return Catch::Session().run(argc, argv);
+}
+
+// NOLINTEND(readability-function-cognitive-complexity, misc-use-anonymous-namespace, cppcoreguidelines-avoid-do-while)
\ No newline at end of file